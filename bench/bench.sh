@@ -0,0 +1,37 @@
+#!/bin/sh
+###############################################
+# Runs the benchmarks on generated corpora
+# usage: bench.sh benchDir periodicTable [lines]
+# The corpora are written once to benchDir/corpus
+# and kept for the next runs.
+###############################################
+DIR=${1:-.}
+TABLE=${2:-../data/periodicTable.txt}
+LINES=${3:-1000000}
+CORPUS=$DIR/corpus
+mkdir -p "$CORPUS" || exit 1
+
+# generate name options... writes a corpus unless it exists
+generate() {
+	NAME=$1
+	shift
+	if [ ! -f "$CORPUS/$NAME.txt" ]; then
+		"$DIR/genCorpus" "$@" > "$CORPUS/$NAME.txt" || exit 1
+	fi
+}
+
+# realistic formulas, half of them repeated
+generate realistic -n "$LINES"
+# every formula different
+generate unique -n "$LINES" -dup 0
+# deep nesting
+generate deep -n $((LINES / 10)) -depth 40 -items 3 -mult 3 -dup 0 -atoms 1000000
+# long lines of many items
+generate long -n $((LINES / 1000)) -items 5000 -depth 1 -mult 3 -dup 0 -atoms 1000000
+# large multipliers, with fewer lines as every one expands to many atoms
+generate multipliers -n $((LINES / 1000)) -mult 1000000 -atoms 1000000 -dup 0
+
+for name in realistic unique deep long multipliers; do
+	echo
+	"$DIR/benchFormula" "$TABLE" "$CORPUS/$name.txt" || exit 1
+done
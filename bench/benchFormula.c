@@ -0,0 +1,402 @@
+/**
+ * @file benchFormula.c
+ *
+ * @brief Benchmark of the formula parser on a corpus file.
+ *
+ * The corpus is read into memory once. The whole runs of -v, -ext, -pn and
+ * -counts are then timed from the input file to /dev/null, followed by the
+ * parsing functions one at a time on the lines in memory. Every result is
+ * the best of a number of repeats, in formulas and megabytes per second.
+ *
+ * usage: benchFormula periodicTable corpus [repeats]
+ *
+ * The program is linked with the sources of the parser compiled with
+ * PARSE_FORMULA_LIBRARY, see the bench target of the makefile.
+ *
+ * @author Nicolas Constantinou
+ * @date 23/10/2024
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <time.h>
+#include "Stack.h"
+#include "periodicTable.h"
+#include "Output.h"
+#include "LineReader.h"
+#include "Balance.h"
+#include "Lexer.h"
+#include "ParseFormula.h"
+#include "Batch.h"
+
+#define KERNEL_BALANCE 0
+#define KERNEL_TOKENIZE 1
+#define KERNEL_COUNT 2
+#define KERNEL_PROTON 3
+#define KERNEL_EXPAND 4
+#define KERNEL_SIZE 5
+
+/**
+ * @brief Names of the kernels in the report.
+ */
+static const char *kernelNames[KERNEL_SIZE] = {
+    "checkBalance", "tokenizeFormula", "countTokens", "printProtonNumber",
+    "printExpansion"};
+
+/**
+ * @struct Kernel
+ *
+ * @brief Buffers shared by the timed parsing functions.
+ */
+typedef struct kernel
+{
+    PeriodicTable *table;
+    TokenStack *tokens;
+    TokenStack *frames;
+    long long *counts;
+    Output *out;
+} Kernel;
+
+/**
+ * @brief Returns the time of a monotonic clock in seconds.
+ *
+ * @return double The time.
+ */
+double now(void)
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (double)time.tv_sec + (double)time.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Prints one line of the report.
+ *
+ * @param name The name of the measured run.
+ * @param seconds The best time of the run.
+ * @param lines The number of formulas of the run.
+ * @param bytes The number of input bytes of the run.
+ */
+void report(const char *name, double seconds, long lines, size_t bytes)
+{
+    if (seconds <= 0)
+    {
+        seconds = 1e-9;
+    }
+    printf("%-24s %10.4f s %14.0f formulas/s %10.1f MB/s\n", name, seconds,
+           (double)lines / seconds, (double)bytes / seconds / 1e6);
+}
+
+/**
+ * @brief Reads a whole file into memory.
+ *
+ * @param fileName The name of the file.
+ * @param data Pointer that receives the allocated contents.
+ * @param length Pointer that receives the number of bytes.
+ * @return int EXIT_SUCCESS on success, EXIT_FAILURE on error.
+ */
+int readCorpus(char *fileName, char **data, size_t *length)
+{
+    FILE *fp = fopen(fileName, "rb");
+    if (fp == NULL)
+    {
+        printf("Could not open the corpus %s!\n", fileName);
+        return EXIT_FAILURE;
+    }
+    size_t capacity = 1 << 20;
+    *length = 0;
+    *data = (char *)malloc(capacity);
+    while (*data != NULL)
+    {
+        size_t count = fread(*data + *length, 1, capacity - *length, fp);
+        *length += count;
+        if (count == 0)
+        {
+            break;
+        }
+        if (*length == capacity)
+        {
+            char *grown = (char *)realloc(*data, capacity * 2);
+            if (grown == NULL)
+            {
+                free(*data);
+                *data = NULL;
+                break;
+            }
+            *data = grown;
+            capacity *= 2;
+        }
+    }
+    fclose(fp);
+    if (*data == NULL)
+    {
+        printf("Could not allocate the corpus!\n");
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Runs one parsing function on one formula.
+ *
+ * @param kernel Pointer to the shared buffers.
+ * @param type The function, one of the KERNEL values.
+ * @param line The formula.
+ * @param length The length of the formula.
+ * @return int EXIT_SUCCESS on success, EXIT_FAILURE for an invalid formula.
+ */
+int runKernel(Kernel *kernel, int type, char *line, size_t length)
+{
+    kernel->out->size = 0;
+    switch (type)
+    {
+    case KERNEL_BALANCE:
+        return checkBalance(line, length);
+    case KERNEL_TOKENIZE:
+        return tokenizeFormula(line, length, kernel->tokens, kernel->frames, kernel->table);
+    case KERNEL_COUNT:
+    case KERNEL_PROTON:
+        if (tokenizeFormula(line, length, kernel->tokens, kernel->frames, kernel->table) == EXIT_FAILURE ||
+            countTokens(kernel->tokens, kernel->counts, kernel->table) == EXIT_FAILURE)
+        {
+            return EXIT_FAILURE;
+        }
+        return type == KERNEL_COUNT ? EXIT_SUCCESS : printProtonNumber(kernel->counts, kernel->table, kernel->out);
+    default:
+        if (tokenizeFormula(line, length, kernel->tokens, kernel->frames, kernel->table) == EXIT_FAILURE)
+        {
+            return EXIT_FAILURE;
+        }
+        return printExpansion(kernel->tokens, kernel->frames, kernel->table, kernel->out);
+    }
+}
+
+/**
+ * @brief Times one parsing function over all the formulas of the corpus.
+ *
+ * @param kernel Pointer to the shared buffers.
+ * @param type The function, one of the KERNEL values.
+ * @param data The corpus.
+ * @param length The number of bytes of the corpus.
+ * @param failed Pointer that receives the number of invalid formulas.
+ * @return double The time in seconds.
+ */
+double timeKernel(Kernel *kernel, int type, char *data, size_t length, long *failed)
+{
+    *failed = 0;
+    double start = now();
+    char *line = data;
+    char *end = data + length;
+    while (line < end)
+    {
+        char *newLine = (char *)memchr(line, '\n', end - line);
+        char *next = newLine == NULL ? end : newLine + 1;
+        size_t size = (newLine == NULL ? end : newLine) - line;
+        if (size > 0 && line[size - 1] == '\r')
+        {
+            size--;
+        }
+        if (runKernel(kernel, type, line, size) == EXIT_FAILURE)
+        {
+            (*failed)++;
+        }
+        line = next;
+    }
+    return now() - start;
+}
+
+/**
+ * @brief Times the -v scan of the whole corpus in memory.
+ *
+ * @param data The corpus.
+ * @param length The number of bytes of the corpus.
+ * @param lines Pointer that receives the number of lines.
+ * @return double The time in seconds.
+ */
+double timeScan(char *data, size_t length, long *lines)
+{
+    BalanceScan scan;
+    initBalanceScan(&scan, 0);
+    double start = now();
+    for (size_t offset = 0; offset < length; offset += BALANCE_BLOCK_SIZE)
+    {
+        size_t size = length - offset < BALANCE_BLOCK_SIZE ? length - offset : BALANCE_BLOCK_SIZE;
+        scanBalance(&scan, data + offset, size);
+    }
+    finishBalance(&scan);
+    double seconds = now() - start;
+    *lines = scan.line - 1;
+    return seconds;
+}
+
+/**
+ * @brief Times a whole run of a mode from the corpus file to /dev/null.
+ *
+ * @param fileName The name of the corpus.
+ * @param table Pointer to the periodic table.
+ * @param options Pointer to the options of the run.
+ * @param mode The mode, one of the MODE values, or -1 for -v.
+ * @return double The time in seconds, negative on failure.
+ */
+double timeFile(char *fileName, PeriodicTable *table, Options *options, int mode)
+{
+    double start = now();
+    if (mode < 0)
+    {
+        BalanceScan scan;
+        initBalanceScan(&scan, 0);
+        if (scanFile(fileName, &scan) == EXIT_FAILURE)
+        {
+            return -1;
+        }
+    }
+    else if (processFile(fileName, "/dev/null", table, options, mode) == EXIT_FAILURE)
+    {
+        return -1;
+    }
+    return now() - start;
+}
+
+/**
+ * @brief Allocates the buffers of the timed functions.
+ *
+ * @param kernel Pointer to the buffers.
+ * @param table Pointer to the periodic table.
+ * @return int EXIT_SUCCESS on success, EXIT_FAILURE on error.
+ */
+int initKernel(Kernel *kernel, PeriodicTable *table)
+{
+    memset(kernel, 0, sizeof(Kernel));
+    kernel->table = table;
+    kernel->counts = (long long *)malloc(table->size * sizeof(long long));
+    if (kernel->counts == NULL || initTokenStack(&kernel->tokens) == EXIT_FAILURE ||
+        initTokenStack(&kernel->frames) == EXIT_FAILURE || openBufferOutput(&kernel->out) == EXIT_FAILURE)
+    {
+        printf("Could not allocate the benchmark!\n");
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Frees the buffers of the timed functions.
+ *
+ * @param kernel Pointer to the buffers.
+ */
+void freeKernel(Kernel *kernel)
+{
+    free(kernel->counts);
+    if (kernel->tokens != NULL)
+    {
+        freeTokenStack(kernel->tokens);
+    }
+    if (kernel->frames != NULL)
+    {
+        freeTokenStack(kernel->frames);
+    }
+    if (kernel->out != NULL)
+    {
+        closeOutput(kernel->out, EXIT_SUCCESS);
+    }
+}
+
+/**
+ * @brief Main entry of the benchmark.
+ *
+ * @param argc The count of command line arguments.
+ * @param argv Array of command line argument strings.
+ * @return int 0 on success, -1 on failure.
+ */
+int main(int argc, char *argv[])
+{
+    if (argc != 3 && argc != 4)
+    {
+        printf("usage: benchFormula periodicTable corpus [repeats]\n");
+        return -1;
+    }
+    int repeats = argc == 4 ? atoi(argv[3]) : 3;
+    if (repeats < 1)
+    {
+        repeats = 1;
+    }
+
+    char *data = NULL;
+    size_t length = 0;
+    if (readCorpus(argv[2], &data, &length) == EXIT_FAILURE)
+    {
+        return -1;
+    }
+
+    double start = now();
+    PeriodicTable *table = getTable(argv[1]);
+    double loadSeconds = now() - start;
+    Kernel kernel;
+    if (table == NULL || initKernel(&kernel, table) == EXIT_FAILURE)
+    {
+        printf("Could not load the periodic table %s!\n", argv[1]);
+        if (table != NULL)
+        {
+            freeKernel(&kernel);
+            freeTable(table);
+        }
+        free(data);
+        return -1;
+    }
+
+    long lines = 0;
+    double best = timeScan(data, length, &lines);
+    printf("corpus %s: %ld formulas, %zu bytes, best of %d\n", argv[2], lines, length, repeats);
+    printf("%-24s %10.4f s\n", "getTable", loadSeconds);
+
+    printf("\nwhole runs, input file to /dev/null\n");
+    Options options = {0, 1, 0, 0, 0, 0, NULL, NULL};
+    const int modes[] = {-1, MODE_EXT, MODE_PN, MODE_COUNTS};
+    const char *modeNames[] = {"-v", "-ext", "-pn", "-counts"};
+    int status = 0;
+    for (int i = 0; i < 4; i++)
+    {
+        double fileSeconds = -1;
+        for (int r = 0; r < repeats; r++)
+        {
+            double seconds = timeFile(argv[2], table, &options, modes[i]);
+            if (seconds >= 0 && (fileSeconds < 0 || seconds < fileSeconds))
+            {
+                fileSeconds = seconds;
+            }
+        }
+        if (fileSeconds < 0)
+        {
+            printf("%-24s failed, the corpus has invalid formulas\n", modeNames[i]);
+            status = -1;
+            continue;
+        }
+        report(modeNames[i], fileSeconds, lines, length);
+    }
+
+    printf("\nparsing functions, corpus in memory\n");
+    for (int r = 1; r < repeats; r++)
+    {
+        long count = 0;
+        double seconds = timeScan(data, length, &count);
+        best = seconds < best ? seconds : best;
+    }
+    report("scanBalance", best, lines, length);
+    for (int type = 0; type < KERNEL_SIZE; type++)
+    {
+        long failed = 0;
+        best = timeKernel(&kernel, type, data, length, &failed);
+        for (int r = 1; r < repeats; r++)
+        {
+            double seconds = timeKernel(&kernel, type, data, length, &failed);
+            best = seconds < best ? seconds : best;
+        }
+        report(kernelNames[type], best, lines, length);
+        if (failed > 0)
+        {
+            printf("%-24s %ld formulas failed\n", "", failed);
+        }
+    }
+
+    freeKernel(&kernel);
+    freeTable(table);
+    free(data);
+    return status;
+}
@@ -0,0 +1,266 @@
+/**
+ * @file genCorpus.c
+ *
+ * @brief Generator of synthetic formula files for the benchmarks.
+ *
+ * Every line is a valid formula of the standard table. The number of lines,
+ * the number of items per group, the nesting depth, the largest multiplier and
+ * the share of lines repeated from a small pool can be chosen, which gives
+ * realistic files as well as adversarial ones with deep nesting, long lines or
+ * large multipliers. The number of atoms of the expansion of every line is
+ * kept under a limit, so the files stay usable with -ext.
+ *
+ * usage: genCorpus [-n lines] [-items N] [-depth D] [-mult M] [-dup percent]
+ *                  [-pool N] [-atoms N] [-seed S]
+ *
+ * @author Nicolas Constantinou
+ * @date 23/10/2024
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+/**
+ * @brief Largest length of a generated line.
+ */
+#define LINE_SIZE (1 << 20)
+
+/**
+ * @brief Largest nesting depth, so the open groups always fit in a line.
+ */
+#define MAX_DEPTH 10000
+
+/**
+ * @brief Elements of the generated formulas, common ones several times.
+ */
+static const char *elements[] = {
+    "H", "H", "H", "H", "C", "C", "C", "C", "O", "O", "O", "N", "N", "S", "P", "Cl",
+    "Na", "K", "Ca", "Mg", "Fe", "Cu", "Zn", "Br", "I", "F", "Si", "Al", "Li", "B",
+    "Ga", "Se", "Mn", "Co", "Ni", "Ag", "Au", "Pt", "Pb", "Sn", "Hg", "U", "Xe", "Uuo"};
+
+/**
+ * @struct Settings
+ *
+ * @brief Shape of the generated formulas.
+ */
+typedef struct settings
+{
+    long lines;
+    int items;
+    int depth;
+    int mult;
+    int dup;
+    int pool;
+    long atoms;
+    unsigned long long seed;
+} Settings;
+
+/**
+ * @brief Returns the next pseudo random number of a xorshift generator.
+ *
+ * The same seed gives the same file on every platform.
+ *
+ * @param state Pointer to the state of the generator.
+ * @return unsigned long long The number.
+ */
+unsigned long long nextRandom(unsigned long long *state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+/**
+ * @brief Returns a pseudo random number from 0 to limit - 1.
+ *
+ * @param state Pointer to the state of the generator.
+ * @param limit The number of values.
+ * @return long The number.
+ */
+long randomBelow(unsigned long long *state, long limit)
+{
+    return (long)(nextRandom(state) % (unsigned long long)limit);
+}
+
+/**
+ * @brief Appends a group of items, and groups nested in it, to a line.
+ *
+ * @param settings Pointer to the shape of the formulas.
+ * @param state Pointer to the state of the generator.
+ * @param line The line.
+ * @param length Pointer to the length of the line.
+ * @param depth The nesting depth of the group.
+ * @param budget The largest number of atoms the group may expand to.
+ * @return long The number of atoms the group expands to.
+ */
+long appendGroup(Settings *settings, unsigned long long *state, char *line, size_t *length, int depth, long budget)
+{
+    long atoms = 0;
+    int items = 1 + (int)randomBelow(state, settings->items);
+    /* every open group needs room for at least an element and its parenthesis */
+    size_t room = LINE_SIZE - 32 * (size_t)(settings->depth + 2);
+    for (int i = 0; i < items; i++)
+    {
+        if (i > 0 && (atoms >= budget || *length >= room))
+        {
+            break;
+        }
+        long size = 1;
+        if (depth < settings->depth && budget - atoms > 1 && *length < room && randomBelow(state, 100) < 35)
+        {
+            line[(*length)++] = '(';
+            size = appendGroup(settings, state, line, length, depth + 1, budget - atoms);
+            line[(*length)++] = ')';
+        }
+        else
+        {
+            const char *name = elements[randomBelow(state, sizeof(elements) / sizeof(elements[0]))];
+            memcpy(line + *length, name, strlen(name));
+            *length += strlen(name);
+        }
+
+        /* the multiplier is cut down so the expansion stays in the budget */
+        long mult = randomBelow(state, 100) < 60 ? 1 + randomBelow(state, settings->mult) : 1;
+        if (size * mult > budget - atoms)
+        {
+            mult = (budget - atoms) / size > 1 ? (budget - atoms) / size : 1;
+        }
+        if (mult > 1)
+        {
+            *length += sprintf(line + *length, "%ld", mult);
+        }
+        atoms += size * mult;
+    }
+    return atoms;
+}
+
+/**
+ * @brief Reads a number option.
+ *
+ * @param argc The count of command line arguments.
+ * @param argv Array of command line argument strings.
+ * @param i Pointer to the position of the option, moved to its value.
+ * @param value Pointer that receives the value.
+ * @return int EXIT_SUCCESS on success, EXIT_FAILURE on error.
+ */
+int readOption(int argc, char *argv[], int *i, long *value)
+{
+    if (*i + 1 >= argc)
+    {
+        return EXIT_FAILURE;
+    }
+    char *end = NULL;
+    *value = strtol(argv[++(*i)], &end, 10);
+    if (*end != '\0' || *value < 0)
+    {
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Main entry of the generator, writes the formulas to the standard output.
+ *
+ * @param argc The count of command line arguments.
+ * @param argv Array of command line argument strings.
+ * @return int 0 on success, -1 on failure.
+ */
+int main(int argc, char *argv[])
+{
+    Settings settings = {1000000, 6, 2, 12, 50, 1000, 100000, 1};
+    for (int i = 1; i < argc; i++)
+    {
+        long value = 0;
+        if (readOption(argc, argv, &i, &value) == EXIT_FAILURE)
+        {
+            printf("usage: genCorpus [-n lines] [-items N] [-depth D] [-mult M] [-dup percent] [-pool N] [-atoms N] [-seed S]\n");
+            return -1;
+        }
+        char *option = argv[i - 1];
+        if (strcmp(option, "-n") == 0)
+        {
+            settings.lines = value;
+        }
+        else if (strcmp(option, "-items") == 0 && value > 0 && value <= 1000000)
+        {
+            settings.items = (int)value;
+        }
+        else if (strcmp(option, "-depth") == 0 && value <= MAX_DEPTH)
+        {
+            settings.depth = (int)value;
+        }
+        else if (strcmp(option, "-mult") == 0 && value > 0 && value <= 1000000000)
+        {
+            settings.mult = (int)value;
+        }
+        else if (strcmp(option, "-dup") == 0 && value <= 100)
+        {
+            settings.dup = (int)value;
+        }
+        else if (strcmp(option, "-pool") == 0 && value > 0 && value <= 100000000)
+        {
+            settings.pool = (int)value;
+        }
+        else if (strcmp(option, "-atoms") == 0 && value > 0)
+        {
+            settings.atoms = value;
+        }
+        else if (strcmp(option, "-seed") == 0 && value > 0)
+        {
+            settings.seed = (unsigned long long)value;
+        }
+        else
+        {
+            printf("Unknown or invalid option %s!\n", argv[i - 1]);
+            return -1;
+        }
+    }
+
+    char *line = (char *)malloc(LINE_SIZE);
+    char **pool = (char **)calloc(settings.pool, sizeof(char *));
+    if (line == NULL || pool == NULL)
+    {
+        printf("Could not allocate the generator!\n");
+        free(line);
+        free(pool);
+        return -1;
+    }
+
+    unsigned long long state = settings.seed * 0x9E3779B97F4A7C15ULL;
+    int status = 0;
+    for (long i = 0; i < settings.lines && status == 0; i++)
+    {
+        /* repeated lines come from a pool filled on first use */
+        int slot = -1;
+        if (randomBelow(&state, 100) < settings.dup)
+        {
+            slot = (int)randomBelow(&state, settings.pool);
+            if (pool[slot] != NULL)
+            {
+                fputs(pool[slot], stdout);
+                continue;
+            }
+        }
+        size_t length = 0;
+        appendGroup(&settings, &state, line, &length, 0, settings.atoms);
+        line[length++] = '\n';
+        line[length] = '\0';
+        if (slot >= 0 && (pool[slot] = (char *)malloc(length + 1)) != NULL)
+        {
+            memcpy(pool[slot], line, length + 1);
+        }
+        if (fwrite(line, 1, length, stdout) != length)
+        {
+            status = -1;
+        }
+    }
+
+    for (int i = 0; i < settings.pool; i++)
+    {
+        free(pool[i]);
+    }
+    free(pool);
+    free(line);
+    return status;
+}
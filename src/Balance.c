@@ -0,0 +1,157 @@
+/**
+ * @file Balance.c
+ *
+ * @brief Vectorized check of balanced parentheses.
+ *
+ * @author Nicolas Constantinou
+ * @date 23/10/2024
+ */
+#include "Balance.h"
+#include "Lexer.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+void initBalanceScan(BalanceScan *scan, int verbose)
+{
+    memset(scan, 0, sizeof(BalanceScan));
+    scan->line = 1;
+    scan->verbose = verbose;
+}
+
+void classifyWindow(const char *data, uint64_t *opens, uint64_t *closes, uint64_t *newLines)
+{
+#ifdef __SSE2__
+    const __m128i open = _mm_set1_epi8('(');
+    const __m128i close = _mm_set1_epi8(')');
+    const __m128i newLine = _mm_set1_epi8('\n');
+    *opens = 0;
+    *closes = 0;
+    *newLines = 0;
+    for (int i = 0; i < BALANCE_WINDOW; i += 16)
+    {
+        __m128i bytes = _mm_loadu_si128((const __m128i *)(data + i));
+        *opens |= (uint64_t)(unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, open)) << i;
+        *closes |= (uint64_t)(unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, close)) << i;
+        *newLines |= (uint64_t)(unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, newLine)) << i;
+    }
+#else
+    *opens = 0;
+    *closes = 0;
+    *newLines = 0;
+    for (int i = 0; i < BALANCE_WINDOW; i++)
+    {
+        *opens |= (uint64_t)(data[i] == '(') << i;
+        *closes |= (uint64_t)(data[i] == ')') << i;
+        *newLines |= (uint64_t)(data[i] == '\n') << i;
+    }
+#endif
+}
+
+void reportBalance(BalanceScan *scan, long column)
+{
+    scan->bad = 1;
+    scan->invalid++;
+    if (scan->invalid == 1)
+    {
+        scan->firstLine = scan->line;
+        scan->firstColumn = column;
+    }
+    if (scan->verbose && scan->report != NULL)
+    {
+        char message[96];
+        int length = snprintf(message, sizeof(message), "Parentheses NOT balanced in line: %ld, column: %ld\n", scan->line, column);
+        writeOutput(scan->report, message, (size_t)length);
+    }
+    else if (scan->verbose)
+    {
+        printf("Parentheses NOT balanced in line: %ld, column: %ld\n", scan->line, column);
+    }
+}
+
+void endBalanceLine(BalanceScan *scan)
+{
+    if (!scan->bad && scan->depth > 0)
+    {
+        reportBalance(scan, scan->open);
+    }
+    scan->line++;
+    scan->depth = 0;
+    scan->bad = 0;
+}
+
+void scanBalance(BalanceScan *scan, const char *data, size_t length)
+{
+    /* column of the current line at position 0 of the block, which may be negative */
+    long base = scan->column;
+    char last[BALANCE_WINDOW];
+
+    for (size_t start = 0; start < length; start += BALANCE_WINDOW)
+    {
+        uint64_t opens, closes, newLines;
+        if (length - start >= BALANCE_WINDOW)
+        {
+            classifyWindow(data + start, &opens, &closes, &newLines);
+        }
+        else
+        {
+            /* the last window is padded with bytes that are never parentheses */
+            memset(last, 0, BALANCE_WINDOW);
+            memcpy(last, data + start, length - start);
+            classifyWindow(last, &opens, &closes, &newLines);
+        }
+
+        uint64_t events = opens | closes | newLines;
+        if ((opens | closes) == 0 && scan->depth == 0 && !scan->bad)
+        {
+            /* no parenthesis, only the lines have to be counted */
+            while (newLines != 0)
+            {
+                int bit = lowestBit(newLines);
+                scan->line++;
+                base = -(long)(start + bit) - 1;
+                newLines &= newLines - 1;
+            }
+            continue;
+        }
+
+        while (events != 0)
+        {
+            int bit = lowestBit(events);
+            uint64_t mask = (uint64_t)1 << bit;
+            long column = base + (long)(start + bit) + 1;
+            if (newLines & mask)
+            {
+                endBalanceLine(scan);
+                base = -(long)(start + bit) - 1;
+            }
+            else if (scan->bad)
+            {
+                /* the rest of a line already reported is skipped */
+            }
+            else if (opens & mask)
+            {
+                if (scan->depth++ == 0)
+                {
+                    scan->open = column;
+                }
+            }
+            else if (scan->depth-- == 0)
+            {
+                reportBalance(scan, column);
+            }
+            events &= events - 1;
+        }
+    }
+    scan->column = base + (long)length;
+}
+
+void finishBalance(BalanceScan *scan)
+{
+    /* a last line without a new line still counts, an empty one does not */
+    if (scan->column > 0 || scan->depth > 0 || scan->bad)
+    {
+        endBalanceLine(scan);
+    }
+}
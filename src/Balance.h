@@ -0,0 +1,113 @@
+/**
+ * @file Balance.h
+ *
+ * @brief Vectorized check of balanced parentheses for whole blocks of lines.
+ *
+ * The data is classified 64 bytes at a time into bit masks of open and close
+ * parentheses and new lines, with SSE2 compares when they are available.
+ * Windows without parentheses only count their new lines. In the other
+ * windows the set bits are visited in order, so the depth is a running sum
+ * of +1 and -1 over the parentheses alone instead of over every byte.
+ *
+ * @author Nicolas Constantinou
+ * @date 23/10/2024
+ */
+#ifndef Balance_h
+#define Balance_h
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdint.h>
+
+#include "Output.h"
+
+/**
+ * @brief Number of bytes classified together.
+ */
+#define BALANCE_WINDOW 64
+
+/**
+ * @brief Bytes of input read at a time by the -v modes.
+ */
+#define BALANCE_BLOCK_SIZE (1 << 20)
+
+/**
+ * @struct BalanceScan
+ *
+ * @brief State of a check that goes on from one block to the next.
+ *
+ * Columns are counted from 1. open is the column of the first parenthesis
+ * opened since the depth of the line was last 0, which is the one left open
+ * when the line ends with a positive depth. bytes counts the bytes read by scanFile.
+ * report, when it is set, receives the messages of verbose instead of the standard output.
+ */
+typedef struct balanceScan
+{
+    long line;
+    long invalid;
+    long firstLine;
+    long firstColumn;
+    long column;
+    long open;
+    size_t bytes;
+    int depth;
+    int bad;
+    int verbose;
+    Output *report;
+} BalanceScan;
+
+/**
+ * @brief Starts a check at the first line.
+ *
+ * @param scan Pointer to the state of the check.
+ * @param verbose Non zero to print every line that is not balanced.
+ */
+void initBalanceScan(BalanceScan *scan, int verbose);
+
+/**
+ * @brief Classifies a window of bytes into bit masks.
+ *
+ * Bit i of every mask is set when byte i of the window is the character of the mask.
+ *
+ * @param data The window, BALANCE_WINDOW bytes long.
+ * @param opens Pointer that receives the mask of '('.
+ * @param closes Pointer that receives the mask of ')'.
+ * @param newLines Pointer that receives the mask of new lines.
+ */
+void classifyWindow(const char *data, uint64_t *opens, uint64_t *closes, uint64_t *newLines);
+
+/**
+ * @brief Checks the parentheses of the lines in a block.
+ *
+ * The block may end in the middle of a line, which goes on in the next block.
+ *
+ * @param scan Pointer to the state of the check.
+ * @param data The bytes of the block.
+ * @param length The number of bytes.
+ */
+void scanBalance(BalanceScan *scan, const char *data, size_t length);
+
+/**
+ * @brief Ends the current line and reports it if it is not balanced.
+ *
+ * @param scan Pointer to the state of the check.
+ */
+void endBalanceLine(BalanceScan *scan);
+
+/**
+ * @brief Ends the check, counting a last line without a new line.
+ *
+ * @param scan Pointer to the state of the check.
+ */
+void finishBalance(BalanceScan *scan);
+
+/**
+ * @brief Records a line that is not balanced at a column.
+ *
+ * @param scan Pointer to the state of the check.
+ * @param column The first offending column of the line.
+ */
+void reportBalance(BalanceScan *scan, long column);
+
+#endif
@@ -0,0 +1,509 @@
+/**
+ * @file Batch.c
+ *
+ * @brief Processing of a whole formula file, on one or several threads.
+ *
+ * @author Nicolas Constantinou
+ * @date 23/10/2024
+ */
+#include "Stack.h"
+#include "periodicTable.h"
+#include "Output.h"
+#include "LineReader.h"
+#include "Balance.h"
+#include "ParseFormula.h"
+#include "Hash.h"
+#include "Bytecode.h"
+#include "Checkpoint.h"
+#include "Batch.h"
+
+int initWorker(Worker *worker, PeriodicTable *table, int mode, Options *options, Output *out)
+{
+    memset(worker, 0, sizeof(Worker));
+    worker->table = table;
+    worker->options = options;
+    worker->mode = mode;
+    worker->out = out;
+    worker->shared = out != NULL;
+    if (out == NULL && openBufferOutput(&worker->out) == EXIT_FAILURE)
+    {
+        return EXIT_FAILURE;
+    }
+    if (mode == MODE_MASS)
+    {
+        worker->massCounts = (long long *)statsMalloc(sizeof(long long) * MASS_BATCH * table->size);
+        if (worker->massCounts == NULL)
+        {
+            printf("Could not allocate the mass batch!\n");
+            return EXIT_FAILURE;
+        }
+    }
+    else if (options->cacheBytes > 0 && initCache(&worker->cache, options->cacheBytes / options->threads) == EXIT_FAILURE)
+    {
+        return EXIT_FAILURE;
+    }
+    if (initTokenStack(&worker->tokens) == EXIT_FAILURE || initTokenStack(&worker->frames) == EXIT_FAILURE)
+    {
+        return EXIT_FAILURE;
+    }
+    worker->counts = (long long *)statsMalloc(sizeof(long long) * table->size);
+    if (worker->counts == NULL)
+    {
+        printf("Could not allocate the element counts!\n");
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+void freeWorker(Worker *worker)
+{
+    if (worker->out != NULL && !worker->shared)
+    {
+        closeOutput(worker->out, EXIT_SUCCESS);
+    }
+    if (worker->tokens != NULL)
+    {
+        freeTokenStack(worker->tokens);
+    }
+    if (worker->frames != NULL)
+    {
+        freeTokenStack(worker->frames);
+    }
+    free(worker->counts);
+    if (worker->cache != NULL)
+    {
+        freeCache(worker->cache);
+    }
+    free(worker->massCounts);
+}
+
+int processLine(Worker *worker, char *line, size_t length)
+{
+    if (worker->cache == NULL)
+    {
+        return parseLine(worker, line, length);
+    }
+
+    unsigned int hash = hashBytes(line, length, HASH_SEED);
+    CacheEntry *entry = findCache(worker->cache, hash, line, length);
+    if (entry != NULL)
+    {
+        return writeOutput(worker->out, entry->data + entry->keyLength, entry->valueLength);
+    }
+
+    Output *out = worker->out;
+    size_t start = out->size;
+    size_t written = out->written;
+    if (parseLine(worker, line, length) == EXIT_FAILURE)
+    {
+        return EXIT_FAILURE;
+    }
+    /* a result split by a flush of the output is not kept, a full cache only skips it */
+    if (out->written == written)
+    {
+        insertCache(worker->cache, hash, line, length, out->buffer + start, out->size - start);
+    }
+    return EXIT_SUCCESS;
+}
+
+int parseLine(Worker *worker, char *line, size_t length)
+{
+    if (worker->bytecode)
+    {
+        if (loadCode(line, length, worker->tokens, worker->frames, worker->table) == EXIT_FAILURE)
+        {
+            return EXIT_FAILURE;
+        }
+    }
+    else if (tokenizeFormula(line, length, worker->tokens, worker->frames, worker->table) == EXIT_FAILURE)
+    {
+        /* only a failed line is checked again to tell why it failed */
+        worker->unbalanced = checkBalance(line, length) == EXIT_FAILURE;
+        return EXIT_FAILURE;
+    }
+    if (worker->options->stats != NULL)
+    {
+        countFormula(&worker->stats, worker->tokens);
+    }
+    long long maxAtoms = worker->options->maxAtoms;
+    if (worker->mode == MODE_EXT && maxAtoms == 0)
+    {
+        return printExpansion(worker->tokens, worker->frames, worker->table, worker->out);
+    }
+    if (worker->mode == MODE_BYTECODE)
+    {
+        return writeCode(worker->out, worker->tokens);
+    }
+
+    /* the counts of -mass go straight to the next row of the batch */
+    long long *counts = worker->counts;
+    if (worker->mode == MODE_MASS)
+    {
+        counts = worker->massCounts + (size_t)worker->massRows * worker->table->size;
+    }
+    /* the counts take time linear in the tokens, whatever the multipliers, so they come first */
+    long long atoms = 0;
+    long long protons = 0;
+    if (countTokens(worker->tokens, counts, worker->table) == EXIT_FAILURE ||
+        (maxAtoms > 0 && (countAtoms(counts, worker->table, &atoms) == EXIT_FAILURE || atoms > maxAtoms)) ||
+        (worker->mode == MODE_PN && protonNumber(counts, worker->table, &protons) == EXIT_FAILURE))
+    {
+        worker->oversized = 1;
+        return EXIT_FAILURE;
+    }
+    if (worker->mode == MODE_EXT)
+    {
+        return printExpansion(worker->tokens, worker->frames, worker->table, worker->out);
+    }
+    if (worker->mode == MODE_COUNTS)
+    {
+        return printHillFormula(counts, worker->table, worker->options->empirical, worker->out);
+    }
+    if (worker->mode == MODE_MASS)
+    {
+        if (++worker->massRows == MASS_BATCH)
+        {
+            return flushMasses(worker);
+        }
+        return EXIT_SUCCESS;
+    }
+    return writeNumber(worker->out, protons);
+}
+
+void countFormula(Stats *stats, TokenStack *tokens)
+{
+    int depth = 0;
+    for (int i = 0; i < tokens->size; i++)
+    {
+        if (tokens->array[i].id == TOKEN_OPEN)
+        {
+            stats->pushes++;
+            if (++depth > stats->peakDepth)
+            {
+                stats->peakDepth = depth;
+            }
+        }
+        else if (tokens->array[i].id == TOKEN_CLOSE)
+        {
+            stats->pops++;
+            depth--;
+        }
+    }
+    stats->pushes += tokens->size;
+}
+
+int flushMasses(Worker *worker)
+{
+    double results[2 * MASS_BATCH];
+    computeMasses(worker->massCounts, worker->massRows, worker->table->size, worker->table->masses, results);
+    int rows = worker->massRows;
+    worker->massRows = 0;
+
+    char line[64];
+    for (int i = 0; i < rows; i++)
+    {
+        int length = snprintf(line, sizeof(line), "%.4f %.6f\n", results[2 * i], results[2 * i + 1]);
+        if (length < 0 || (size_t)length >= sizeof(line) || writeOutput(worker->out, line, length) == EXIT_FAILURE)
+        {
+            return EXIT_FAILURE;
+        }
+    }
+    return EXIT_SUCCESS;
+}
+
+void *runWorker(void *arg)
+{
+    Worker *worker = (Worker *)arg;
+    char *line = worker->data;
+    char *end = worker->data + worker->length;
+
+    if (!worker->shared)
+    {
+        worker->out->size = 0;
+    }
+    worker->lines = 0;
+    worker->failedLine = 0;
+    worker->unbalanced = 0;
+    worker->oversized = 0;
+    while (line < end)
+    {
+        char *next = end;
+        size_t length = end - line;
+        if (worker->bytecode)
+        {
+            /* the blocks of nextCodeBlock hold complete records */
+            length = codeSize(line, end - line);
+            next = line + length;
+        }
+        else
+        {
+            char *newLine = (char *)memchr(line, '\n', length);
+            if (newLine != NULL)
+            {
+                length = newLine - line;
+                next = newLine + 1;
+            }
+        }
+        worker->lines++;
+        if (processLine(worker, line, length) == EXIT_FAILURE)
+        {
+            worker->failedLine = worker->lines;
+            break;
+        }
+        if (worker->maxOutput > 0 && worker->out->size > worker->maxOutput)
+        {
+            worker->oversized = 1;
+            worker->failedLine = worker->lines;
+            break;
+        }
+        line = next;
+    }
+    /* the formulas before a failed line still get their masses */
+    if (worker->massRows > 0 && flushMasses(worker) == EXIT_FAILURE && worker->failedLine == 0)
+    {
+        worker->failedLine = worker->lines;
+    }
+    return NULL;
+}
+
+void reportCache(Worker *workers, int count, char *name)
+{
+    long hits = 0;
+    long misses = 0;
+    long evictions = 0;
+    for (int i = 0; i < count; i++)
+    {
+        if (workers[i].cache != NULL)
+        {
+            hits += workers[i].cache->hits;
+            misses += workers[i].cache->misses;
+            evictions += workers[i].cache->evictions;
+        }
+    }
+    double rate = hits + misses > 0 ? 100.0 * hits / (hits + misses) : 0.0;
+    printf("%s%sCache hits: %ld of %ld formulas (%.1f%%), %ld evictions\n", name != NULL ? name : "",
+           name != NULL ? ": " : "", hits, hits + misses, rate, evictions);
+}
+
+int processFile(char *fileName, char *outFileName, PeriodicTable *table, Options *options, int mode)
+{
+    Stats *stats = options->stats;
+    if (stats != NULL)
+    {
+        startTimer(&stats->parse);
+    }
+    /* the messages of a file of a batch start with its name */
+    char *name = options->name != NULL ? options->name : "";
+    char *separator = options->name != NULL ? ": " : "";
+    LineReader *reader = NULL;
+    if (openReader(&reader, fileName) == EXIT_FAILURE)
+    {
+        return EXIT_FAILURE;
+    }
+
+    int threads = options->threads;
+    Worker *workers = (Worker *)statsCalloc(threads, sizeof(Worker));
+    if (workers == NULL)
+    {
+        printf("Could not allocate the workers!\n");
+        closeReader(reader);
+        return EXIT_FAILURE;
+    }
+
+    int bytecode = readCodeHeader(reader, table);
+    int status = bytecode < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+    long line = 0;
+    Checkpoint *checkpoint = NULL;
+    if (status == EXIT_SUCCESS && options->incremental)
+    {
+        status = openCheckpoint(&checkpoint, fileName, outFileName, table, options->empirical, mode);
+    }
+    if (checkpoint != NULL && bytecode)
+    {
+        printf("%s%s--incremental needs formulas, not bytecode!\n", name, separator);
+        status = EXIT_FAILURE;
+    }
+    if (checkpoint != NULL && status == EXIT_SUCCESS && checkpoint->input > 0)
+    {
+        status = resumeInput(checkpoint, reader, fileName);
+        line = (long)checkpoint->lines;
+    }
+    long firstLine = line;
+
+    Output *out = NULL;
+    if (status == EXIT_SUCCESS)
+    {
+        status = checkpoint != NULL ? openAppendOutput(&out, outFileName, (size_t)checkpoint->output)
+                                    : openOutput(&out, outFileName, options->atomic);
+    }
+    if (out != NULL)
+    {
+        out->stats = stats;
+    }
+    if (status == EXIT_SUCCESS && line > 0)
+    {
+        printf("%s%sResuming from line %ld\n", name, separator, line + 1);
+    }
+    /* an output that is appended to has its header already */
+    if (status == EXIT_SUCCESS && mode == MODE_BYTECODE && out->written == 0)
+    {
+        status = writeCodeHeader(out, table);
+    }
+    int ready = 0;
+    while (ready < threads && status == EXIT_SUCCESS)
+    {
+        status = initWorker(&workers[ready], table, mode, options, threads == 1 ? out : NULL);
+        workers[ready].bytecode = bytecode;
+        ready++;
+    }
+
+    char *block = NULL;
+    size_t end = 0;
+    while (status == EXIT_SUCCESS)
+    {
+        size_t size = (size_t)BATCH_BLOCK_SIZE * threads;
+        int read = bytecode ? nextCodeBlock(reader, size, &block, &end) : nextBlock(reader, size, &block, &end);
+        if (read <= 0)
+        {
+            status = read < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+            break;
+        }
+        /* a last line without its new line may still be being written, it waits for the next run */
+        while (checkpoint != NULL && end > 0 && block[end - 1] != '\n')
+        {
+            end--;
+        }
+        if (end == 0)
+        {
+            break;
+        }
+        if (stats != NULL)
+        {
+            stats->bytesIn += end;
+        }
+
+        /* split the block at the first new line, or the first record, after every equal share */
+        size_t start = 0;
+        for (int i = 0; i < threads; i++)
+        {
+            size_t stop = end;
+            if (i < threads - 1 && bytecode)
+            {
+                size_t share = start + (end - start) / (threads - i);
+                stop = start;
+                while (stop < share)
+                {
+                    stop += codeSize(block + stop, end - stop);
+                }
+            }
+            else if (i < threads - 1)
+            {
+                stop = start + (end - start) / (threads - i);
+                char *newLine = (char *)memchr(block + stop, '\n', end - stop);
+                stop = newLine == NULL ? end : (size_t)(newLine - block) + 1;
+            }
+            workers[i].data = block + start;
+            workers[i].length = stop - start;
+            start = stop;
+        }
+
+        if (threads == 1)
+        {
+            runWorker(&workers[0]);
+        }
+        else
+        {
+            int started = 0;
+            for (; started < threads; started++)
+            {
+                if (pthread_create(&workers[started].thread, NULL, runWorker, &workers[started]) != 0)
+                {
+                    printf("Could not start a worker thread!\n");
+                    status = EXIT_FAILURE;
+                    break;
+                }
+            }
+            for (int i = 0; i < started; i++)
+            {
+                pthread_join(workers[i].thread, NULL);
+            }
+            if (status == EXIT_FAILURE)
+            {
+                break;
+            }
+        }
+
+        for (int i = 0; i < threads && status == EXIT_SUCCESS; i++)
+        {
+            if (!workers[i].shared && writeOutput(out, workers[i].out->buffer, workers[i].out->size) == EXIT_FAILURE)
+            {
+                status = EXIT_FAILURE;
+            }
+            else if (workers[i].failedLine > 0)
+            {
+                if (workers[i].unbalanced)
+                {
+                    printf("%s%sNot valid parenthesis in line: %ld\n", name, separator, line + workers[i].failedLine);
+                }
+                else if (workers[i].oversized)
+                {
+                    printf("%s%sToo many atoms in line: %ld\n", name, separator, line + workers[i].failedLine);
+                }
+                else if (bytecode)
+                {
+                    printf("%s%sNot valid bytecode in formula: %ld\n", name, separator, line + workers[i].failedLine);
+                }
+                status = EXIT_FAILURE;
+            }
+            line += workers[i].lines;
+        }
+
+        /* a stream gets the results of every block as soon as they are ready */
+        if (status == EXIT_SUCCESS && out->stream)
+        {
+            status = flushOutput(out);
+        }
+        if (status == EXIT_SUCCESS && checkpoint != NULL)
+        {
+            advanceCheckpoint(checkpoint, block, end, line);
+            if (checkpoint->input - checkpoint->saved >= CHECKPOINT_INTERVAL)
+            {
+                status = saveCheckpoint(checkpoint, out);
+            }
+        }
+    }
+    /* a failed run keeps the last checkpoint, the next run cuts the output back to it */
+    if (status == EXIT_SUCCESS && checkpoint != NULL && checkpoint->input > checkpoint->saved)
+    {
+        status = saveCheckpoint(checkpoint, out);
+    }
+
+    if (options->cacheBytes > 0 && mode != MODE_MASS)
+    {
+        reportCache(workers, ready, options->name);
+    }
+    for (int i = 0; i < ready; i++)
+    {
+        if (stats != NULL)
+        {
+            mergeStats(stats, &workers[i].stats);
+        }
+        freeWorker(&workers[i]);
+    }
+    if (out != NULL)
+    {
+        status = closeOutput(out, status);
+    }
+    if (checkpoint != NULL)
+    {
+        closeCheckpoint(checkpoint);
+    }
+    free(workers);
+    closeReader(reader);
+    if (stats != NULL)
+    {
+        stats->lines += line - firstLine;
+        stopTimer(&stats->parse);
+    }
+    return status;
+}
@@ -0,0 +1,188 @@
+/**
+ * @file Batch.h
+ *
+ * @brief Processing of a whole formula file, on one or several threads.
+ *
+ * The input is read with a LineReader in large blocks of complete lines. Every block is split
+ * at line boundaries between the workers, which parse their lines into
+ * output buffers of their own while sharing the read-only periodic table.
+ * The buffers are then written in the order of the workers, so the output
+ * is the same for any number of threads. A single worker writes straight to
+ * the output file instead, so even a huge expansion is never held in memory.
+ *
+ * @author Nicolas Constantinou
+ * @date 23/10/2024
+ */
+#ifndef Batch_h
+#define Batch_h
+
+#include <pthread.h>
+
+#include "Cache.h"
+#include "Mass.h"
+#include "Stats.h"
+
+/**
+ * @brief Bytes of input read per worker for every block.
+ */
+#define BATCH_BLOCK_SIZE (1 << 20)
+
+/**
+ * @brief Largest number of worker threads.
+ */
+#define MAX_THREADS 1024
+
+#define MODE_EXT 0
+#define MODE_PN 1
+#define MODE_COUNTS 2
+#define MODE_MASS 3
+#define MODE_BYTECODE 4
+
+/**
+ * @struct Worker
+ *
+ * @brief Work space and results of one worker for the current block.
+ *
+ * maxOutput, when it is not 0, is the most bytes of results of a block; the
+ * line that goes over it fails as oversized.
+ */
+typedef struct worker
+{
+    pthread_t thread;
+    PeriodicTable *table;
+    Options *options;
+    int mode;
+    TokenStack *tokens;
+    TokenStack *frames;
+    long long *counts;
+    Cache *cache;
+    long long *massCounts;
+    int massRows;
+    Output *out;
+    int shared;
+    int bytecode;
+    char *data;
+    size_t length;
+    long lines;
+    long failedLine;
+    int unbalanced;
+    int oversized;
+    size_t maxOutput;
+    Stats stats;
+} Worker;
+
+/**
+ * @brief Allocates the work space of a worker.
+ *
+ * MODE_MASS keeps the counts of up to MASS_BATCH formulas and writes their
+ * masses together, so it does not use the cache.
+ *
+ * @param worker Pointer to the worker to initialize.
+ * @param table Pointer to the periodic table shared by all workers.
+ * @param mode MODE_EXT, MODE_PN, MODE_COUNTS, MODE_MASS or MODE_BYTECODE.
+ * @param options Pointer to the command line options.
+ * @param out Output the worker writes to directly, or NULL for an output buffer of its own.
+ * @return int EXIT_SUCCESS on success, EXIT_FAILURE on error.
+ */
+int initWorker(Worker *worker, PeriodicTable *table, int mode, Options *options, Output *out);
+
+/**
+ * @brief Frees the work space of a worker.
+ *
+ * @param worker Pointer to the worker.
+ */
+void freeWorker(Worker *worker);
+
+/**
+ * @brief Checks, parses and writes the result of one formula.
+ *
+ * With a cache the result of a formula seen before is copied from the cache,
+ * and the result of a new formula is stored in it.
+ *
+ * @param worker Pointer to the worker.
+ * @param line The formula string, without its new line.
+ * @param length The length of the formula.
+ * @return int EXIT_SUCCESS on success, EXIT_FAILURE on error. unbalanced is set
+ * when the parentheses of the formula are not balanced.
+ */
+int processLine(Worker *worker, char *line, size_t length);
+
+/**
+ * @brief Checks, parses and writes the result of one formula without the cache.
+ *
+ * Every mode reads the formula with tokenizeFormula, or copies its tokens from
+ * a record of a bytecode file. -ext streams the expansion of the tokens,
+ * -bytecode writes them as a record, the other modes compute the element
+ * counts with countTokens. With options->maxAtoms -ext counts the atoms too,
+ * so a formula over the budget fails before anything is expanded.
+ *
+ * @param worker Pointer to the worker.
+ * @param line The formula string, without its new line, or the record of the formula.
+ * @param length The length of the formula.
+ * @return int EXIT_SUCCESS on success, EXIT_FAILURE on error. oversized is set
+ * when the formula has more atoms than the budget or than 64 bits hold.
+ */
+int parseLine(Worker *worker, char *line, size_t length);
+
+/**
+ * @brief Adds the stack operations of a formula read by tokenizeFormula to the counters of a worker.
+ *
+ * Every token is a push, and every group a push and a pop of its open
+ * parenthesis. The deepest group gives the peak depth.
+ *
+ * @param stats Pointer to the counters.
+ * @param tokens The tokens of the formula.
+ */
+void countFormula(Stats *stats, TokenStack *tokens);
+
+/**
+ * @brief Computes and writes the masses of the formulas kept by a worker.
+ *
+ * @param worker Pointer to the worker.
+ * @return int EXIT_SUCCESS on success, EXIT_FAILURE on error.
+ */
+int flushMasses(Worker *worker);
+
+/**
+ * @brief Processes all the lines given to a worker.
+ *
+ * The lines, or the records when bytecode is set, are parsed in place in data. The worker stops
+ * at the first line that fails and stores its number, counted from 1 within
+ * the data, in failedLine. Its output then holds the results of the lines before.
+ * An output buffer of its own is emptied first.
+ *
+ * @param worker Pointer to the worker, passed as void* to be a thread function.
+ * @return void* Always NULL.
+ */
+void *runWorker(void *worker);
+
+/**
+ * @brief Prints the hits, lookups and evictions of the caches of all workers.
+ *
+ * @param workers Array of the workers.
+ * @param count Number of workers.
+ * @param name Name of the input file of a batch printed first, NULL for none.
+ */
+void reportCache(Worker *workers, int count, char *name);
+
+/**
+ * @brief Runs a parsing mode over a whole file.
+ *
+ * The lines are processed by options->threads workers and the results are
+ * written in the original order of the lines. Processing stops at the first
+ * line that fails, and the results of all the lines before it are kept,
+ * unless the atomic option is given. With options->cacheBytes every worker
+ * keeps a cache with its share of the bytes, and the hits are reported at the end.
+ * The input may be a bytecode file of the same table, whose records are then
+ * read in place of the lines. MODE_BYTECODE writes such a file.
+ *
+ * @param fileName Name of the input file with chemical formulas.
+ * @param outFileName Name of the output file.
+ * @param table Pointer to the periodic table structure.
+ * @param options Pointer to the command line options.
+ * @param mode MODE_EXT, MODE_PN, MODE_COUNTS, MODE_MASS or MODE_BYTECODE.
+ * @return int EXIT_SUCCESS on success, EXIT_FAILURE on error.
+ */
+int processFile(char *fileName, char *outFileName, PeriodicTable *table, Options *options, int mode);
+
+#endif
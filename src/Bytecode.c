@@ -0,0 +1,275 @@
+/**
+ * @file Bytecode.c
+ *
+ * @brief Formulas compiled once to bytecode and evaluated without parsing.
+ *
+ * @author Nicolas Constantinou
+ * @date 23/10/2024
+ */
+#include <limits.h>
+#include <sys/stat.h>
+#include "Hash.h"
+#include "Bytecode.h"
+
+uint32_t hashTable(PeriodicTable *table)
+{
+    /* the symbols and the proton numbers in the order of the ids, the numbers as 4 bytes little endian */
+    uint32_t hash = HASH_SEED;
+    for (int i = 0; i < table->size; i++)
+    {
+        uint32_t number = (uint32_t)table->array[i].periodicNum;
+        char bytes[4];
+        for (int j = 0; j < 4; j++)
+        {
+            bytes[j] = (char)((number >> (8 * j)) & 0xff);
+        }
+        hash = hashBytes(table->array[i].name, strlen(table->array[i].name), hash);
+        hash = hashBytes(bytes, sizeof(bytes), hash);
+    }
+    return hash;
+}
+
+int writeCodeHeader(Output *out, PeriodicTable *table)
+{
+    CodeHeader header;
+    memset(&header, 0, sizeof(CodeHeader));
+    memcpy(header.magic, CODE_MAGIC, sizeof(CODE_MAGIC));
+    header.tableSize = table->size;
+    header.tableHash = hashTable(table);
+    return writeOutput(out, (const char *)&header, sizeof(CodeHeader));
+}
+
+int readCodeHeader(LineReader *reader, PeriodicTable *table)
+{
+    /* a pipe is read as text, waiting for the bytes of a header would hold back its first lines */
+    struct stat info;
+    if (fstat(reader->fd, &info) != 0 || !S_ISREG(info.st_mode))
+    {
+        return 0;
+    }
+    char *data = NULL;
+    int status = peekBytes(reader, sizeof(CodeHeader), &data);
+    if (status <= 0)
+    {
+        return status;
+    }
+    if (memcmp(data, CODE_MAGIC, sizeof(CODE_MAGIC)) != 0)
+    {
+        return 0;
+    }
+    CodeHeader header;
+    memcpy(&header, data, sizeof(CodeHeader));
+    if (header.tableSize != table->size || header.tableHash != hashTable(table))
+    {
+        printf("The bytecode was compiled with another periodic table!\n");
+        return -1;
+    }
+    reader->start += sizeof(CodeHeader);
+    return 1;
+}
+
+size_t writeVarint(unsigned char *buffer, uint64_t value)
+{
+    size_t size = 0;
+    while (value >= 0x80)
+    {
+        buffer[size++] = (unsigned char)(value | 0x80);
+        value >>= 7;
+    }
+    buffer[size++] = (unsigned char)value;
+    return size;
+}
+
+size_t readVarint(const unsigned char *data, size_t length, uint64_t *value)
+{
+    uint64_t result = 0;
+    for (size_t i = 0; i < length && i < VARINT_SIZE; i++)
+    {
+        result |= (uint64_t)(data[i] & 0x7f) << (7 * i);
+        if ((data[i] & 0x80) == 0)
+        {
+            *value = result;
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+size_t encodeToken(Token *token, unsigned char *buffer)
+{
+    /* tokenizeFormula keeps every count from 0 to INT_MAX */
+    uint32_t count = (uint32_t)token->count;
+    if (token->id == TOKEN_OPEN)
+    {
+        buffer[0] = CODE_OPEN;
+        return 1;
+    }
+    if (token->id == TOKEN_CLOSE)
+    {
+        return writeVarint(buffer, (uint64_t)count << 2 | CODE_CLOSE_MUL);
+    }
+    if (count == 1)
+    {
+        return writeVarint(buffer, (uint64_t)token->id << 2 | CODE_PUSH);
+    }
+    size_t size = writeVarint(buffer, (uint64_t)token->id << 2 | CODE_PUSH_COUNT);
+    return size + writeVarint(buffer + size, count);
+}
+
+int writeCode(Output *out, TokenStack *tokens)
+{
+    unsigned char buffer[256];
+    size_t length = 0;
+    for (int i = 0; i < tokens->size; i++)
+    {
+        length += encodeToken(&tokens->array[i], buffer);
+    }
+    size_t size = writeVarint(buffer, length);
+    for (int i = 0; i < tokens->size; i++)
+    {
+        if (size > sizeof(buffer) - 2 * VARINT_SIZE)
+        {
+            if (writeOutput(out, (const char *)buffer, size) == EXIT_FAILURE)
+            {
+                return EXIT_FAILURE;
+            }
+            size = 0;
+        }
+        size += encodeToken(&tokens->array[i], buffer + size);
+    }
+    return writeOutput(out, (const char *)buffer, size);
+}
+
+size_t codeSize(const char *data, size_t length)
+{
+    uint64_t value = 0;
+    size_t size = readVarint((const unsigned char *)data, length, &value);
+    if (size == 0 || value > SIZE_MAX - size)
+    {
+        return 0;
+    }
+    return size + (size_t)value;
+}
+
+int nextCodeBlock(LineReader *reader, size_t size, char **block, size_t *length)
+{
+    /* the window may move while it fills, so the records are counted from start */
+    size_t used = 0;
+    char *data = NULL;
+    while (used < size)
+    {
+        size_t available = reader->end - reader->start;
+        if (available == used)
+        {
+            int status = peekBytes(reader, used + 1, &data);
+            if (status < 0)
+            {
+                return -1;
+            }
+            if (status == 0)
+            {
+                break;
+            }
+            available = reader->end - reader->start;
+        }
+        size_t record = codeSize(reader->data + reader->start + used, available - used);
+        if (record == 0 && available - used < VARINT_SIZE)
+        {
+            /* the size of the record may go on in the bytes not read yet */
+            int status = peekBytes(reader, available + 1, &data);
+            if (status < 0)
+            {
+                return -1;
+            }
+            available = reader->end - reader->start;
+            record = codeSize(reader->data + reader->start + used, available - used);
+        }
+        if (record == 0 || peekBytes(reader, used + record, &data) <= 0)
+        {
+            printf("The bytecode ends inside a formula!\n");
+            return -1;
+        }
+        used += record;
+    }
+
+    if (used == 0)
+    {
+        return 0;
+    }
+    *block = reader->data + reader->start;
+    *length = used;
+    reader->start += used;
+    return 1;
+}
+
+int loadCode(const char *data, size_t length, TokenStack *tokens, TokenStack *frames, PeriodicTable *table)
+{
+    const unsigned char *code = (const unsigned char *)data;
+    uint64_t value = 0;
+    size_t i = readVarint(code, length, &value);
+    if (i == 0 || value != length - i || value >= INT_MAX)
+    {
+        return EXIT_FAILURE;
+    }
+    /* every instruction takes at least a byte */
+    tokens->size = 0;
+    frames->size = 0;
+    if (reserveTokens(tokens, (int)value) == EXIT_FAILURE)
+    {
+        return EXIT_FAILURE;
+    }
+
+    while (i < length)
+    {
+        size_t size = readVarint(code + i, length - i, &value);
+        if (size == 0)
+        {
+            return EXIT_FAILURE;
+        }
+        i += size;
+        int op = (int)(value & 3);
+        value >>= 2;
+        Token *token = &tokens->array[tokens->size];
+        if (op == CODE_OPEN)
+        {
+            if (value != 0 || pushToken(frames, tokens->size, 0) == EXIT_FAILURE)
+            {
+                return EXIT_FAILURE;
+            }
+            token->id = TOKEN_OPEN;
+            token->count = 0;
+        }
+        else if (op == CODE_CLOSE_MUL)
+        {
+            /* an empty group is refused, as tokenizeFormula refuses () */
+            if (frames->size == 0 || value > INT_MAX || frames->array[frames->size - 1].id == tokens->size - 1)
+            {
+                return EXIT_FAILURE;
+            }
+            tokens->array[frames->array[--frames->size].id].count = tokens->size;
+            token->id = TOKEN_CLOSE;
+            token->count = (int)value;
+        }
+        else
+        {
+            if (value >= (uint64_t)table->size)
+            {
+                return EXIT_FAILURE;
+            }
+            token->id = (int)value;
+            token->count = 1;
+            if (op == CODE_PUSH_COUNT)
+            {
+                size = readVarint(code + i, length - i, &value);
+                if (size == 0 || value > INT_MAX)
+                {
+                    return EXIT_FAILURE;
+                }
+                i += size;
+                token->count = (int)value;
+            }
+        }
+        tokens->size++;
+    }
+    return frames->size == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
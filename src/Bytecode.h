@@ -0,0 +1,174 @@
+/**
+ * @file Bytecode.h
+ *
+ * @brief Formulas compiled once to bytecode and evaluated without parsing.
+ *
+ * -bytecode compiles every formula of a file to the tokens of tokenizeFormula
+ * and writes them to a bytecode file. -ext, -pn, -counts and -mass read such a
+ * file in place of the formulas, so the later passes over the same formulas
+ * decode the tokens instead of reading the text again.
+ *
+ * The file starts with a CodeHeader. Every formula is then a record of its
+ * size in bytes followed by its instructions. Every number is an unsigned
+ * LEB128 varint, and the two low bits of the first number of an instruction
+ * give its opcode:
+ *
+ *     PUSH_ELEM id      id << 2 | 0           element id once
+ *     PUSH_ELEM id n    id << 2 | 1, n        element id repeated n times
+ *     OPEN              2                     start of a group
+ *     CLOSE_MUL n       n << 2 | 3            end of a group repeated n times
+ *
+ * so most instructions take a single byte and a file is about as large as the
+ * text of its formulas. Loading a record rebuilds the tokens, with the
+ * position of the closing token in every OPEN, without looking up a symbol.
+ *
+ * @author Nicolas Constantinou
+ * @date 23/10/2024
+ */
+#ifndef Bytecode_h
+#define Bytecode_h
+
+#include <stdint.h>
+
+#include "Stack.h"
+#include "periodicTable.h"
+#include "Output.h"
+#include "LineReader.h"
+
+/**
+ * @brief First bytes of a bytecode file.
+ */
+#define CODE_MAGIC "PFCODE1"
+
+#define CODE_PUSH 0
+#define CODE_PUSH_COUNT 1
+#define CODE_OPEN 2
+#define CODE_CLOSE_MUL 3
+
+/**
+ * @brief Largest size of a varint of 64 bits.
+ */
+#define VARINT_SIZE 10
+
+/**
+ * @struct CodeHeader
+ *
+ * @brief Header of a bytecode file.
+ *
+ * The element ids are indexes in the periodic table, so the file records the
+ * size and a hash of the table it was compiled with.
+ */
+typedef struct codeHeader
+{
+    char magic[8];
+    int32_t tableSize;
+    uint32_t tableHash;
+} CodeHeader;
+
+/**
+ * @brief Computes the hash of the symbols and proton numbers of a periodic table.
+ *
+ * @param table Pointer to the periodic table.
+ * @return uint32_t The hash.
+ */
+uint32_t hashTable(PeriodicTable *table);
+
+/**
+ * @brief Writes the header of a bytecode file.
+ *
+ * @param out Pointer to the output.
+ * @param table Pointer to the periodic table of the formulas.
+ * @return int EXIT_SUCCESS on success, EXIT_FAILURE on error.
+ */
+int writeCodeHeader(Output *out, PeriodicTable *table);
+
+/**
+ * @brief Reads the header of a file if it is a bytecode file.
+ *
+ * Nothing is consumed from a text file. Only regular files are checked, so a
+ * pipe or a terminal is always read as text and its lines are not held back.
+ *
+ * @param reader Pointer to the reader at the start of the file.
+ * @param table Pointer to the periodic table of the run.
+ * @return int 1 for a bytecode file of the table, 0 for a text file, -1 on error
+ * or for a bytecode file compiled with another table.
+ */
+int readCodeHeader(LineReader *reader, PeriodicTable *table);
+
+/**
+ * @brief Writes a number as a varint.
+ *
+ * @param buffer Buffer of at least VARINT_SIZE bytes.
+ * @param value The number.
+ * @return size_t The number of bytes written.
+ */
+size_t writeVarint(unsigned char *buffer, uint64_t value);
+
+/**
+ * @brief Reads a varint.
+ *
+ * @param data The first byte of the varint.
+ * @param length The number of bytes that may be read.
+ * @param value Pointer that receives the number.
+ * @return size_t The number of bytes read, 0 if the varint does not end within length bytes.
+ */
+size_t readVarint(const unsigned char *data, size_t length, uint64_t *value);
+
+/**
+ * @brief Encodes a token as an instruction.
+ *
+ * @param token Pointer to the token.
+ * @param buffer Buffer of at least 2 * VARINT_SIZE bytes.
+ * @return size_t The number of bytes written.
+ */
+size_t encodeToken(Token *token, unsigned char *buffer);
+
+/**
+ * @brief Writes the record of a formula read by tokenizeFormula.
+ *
+ * @param out Pointer to the output.
+ * @param tokens The tokens of the formula.
+ * @return int EXIT_SUCCESS on success, EXIT_FAILURE on error.
+ */
+int writeCode(Output *out, TokenStack *tokens);
+
+/**
+ * @brief Returns the size of the record that starts at data.
+ *
+ * @param data The first byte of the record.
+ * @param length The number of bytes that may be read.
+ * @return size_t The size of the record with its size, 0 if its size does not end within length bytes.
+ */
+size_t codeSize(const char *data, size_t length);
+
+/**
+ * @brief Returns the next block of complete records of a bytecode file.
+ *
+ * The block holds about size bytes and stays valid like a block of nextBlock.
+ *
+ * @param reader Pointer to the reader, after the header.
+ * @param size The wanted size of the block.
+ * @param block Pointer to store the first byte of the block.
+ * @param length Pointer to store the length of the block.
+ * @return int 1 if a block was returned, 0 at the end of the file, -1 on error
+ * or for a file that ends inside a record.
+ */
+int nextCodeBlock(LineReader *reader, size_t size, char **block, size_t *length);
+
+/**
+ * @brief Decodes a record into tokens, as tokenizeFormula would leave them.
+ *
+ * The instructions are checked, so a damaged file cannot make the evaluation
+ * read outside of the tokens or the table, and a record is refused for what
+ * tokenizeFormula refuses in the text, such as an empty group.
+ *
+ * @param data The record.
+ * @param length The size of the record.
+ * @param tokens Pointer to the stack that receives the tokens.
+ * @param frames Pointer to a stack used for the open groups.
+ * @param table Pointer to the periodic table.
+ * @return int EXIT_SUCCESS on success, EXIT_FAILURE for a record that is not valid.
+ */
+int loadCode(const char *data, size_t length, TokenStack *tokens, TokenStack *frames, PeriodicTable *table);
+
+#endif
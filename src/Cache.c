@@ -0,0 +1,137 @@
+/**
+ * @file Cache.c
+ *
+ * @brief Bounded cache of formula results with CLOCK eviction.
+ *
+ * @author Nicolas Constantinou
+ * @date 23/10/2024
+ */
+#include "Cache.h"
+#include "Stats.h"
+
+int initCache(Cache **cache, size_t limit)
+{
+    (*cache) = (Cache *)statsCalloc(1, sizeof(Cache));
+    if ((*cache) == NULL)
+    {
+        printf("Could not allocate the cache!\n");
+        return EXIT_FAILURE;
+    }
+    size_t buckets = CACHE_MIN_BUCKETS;
+    while (buckets < limit / CACHE_ENTRY_ESTIMATE && buckets < (1u << 30))
+    {
+        buckets *= 2;
+    }
+    (*cache)->mask = (unsigned int)(buckets - 1);
+    (*cache)->limit = limit;
+    (*cache)->buckets = (CacheEntry **)statsCalloc(buckets, sizeof(CacheEntry *));
+    if ((*cache)->buckets == NULL)
+    {
+        printf("Could not allocate the cache!\n");
+        free(*cache);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+CacheEntry *findCache(Cache *cache, unsigned int hash, const char *key, size_t length)
+{
+    CacheEntry *entry = cache->buckets[hash & cache->mask];
+    while (entry != NULL)
+    {
+        if (entry->hash == hash && entry->keyLength == length && memcmp(entry->data, key, length) == 0)
+        {
+            entry->referenced = 1;
+            cache->hits++;
+            return entry;
+        }
+        entry = entry->next;
+    }
+    cache->misses++;
+    return NULL;
+}
+
+void evictEntry(Cache *cache)
+{
+    CacheEntry *entry = cache->ring[cache->hand];
+    CacheEntry **link = &cache->buckets[entry->hash & cache->mask];
+    while (*link != entry)
+    {
+        link = &(*link)->next;
+    }
+    *link = entry->next;
+
+    /* the last entry of the ring takes the free slot */
+    cache->ringSize--;
+    cache->ring[cache->hand] = cache->ring[cache->ringSize];
+    cache->bytes -= sizeof(CacheEntry) + entry->keyLength + entry->valueLength;
+    cache->evictions++;
+    free(entry);
+}
+
+int insertCache(Cache *cache, unsigned int hash, const char *key, size_t keyLength, const char *value, size_t valueLength)
+{
+    size_t size = sizeof(CacheEntry) + keyLength + valueLength;
+    if (size > cache->limit / 16)
+    {
+        return EXIT_SUCCESS;
+    }
+
+    while (cache->bytes + size > cache->limit && cache->ringSize > 0)
+    {
+        if (cache->hand >= cache->ringSize)
+        {
+            cache->hand = 0;
+        }
+        if (cache->ring[cache->hand]->referenced)
+        {
+            cache->ring[cache->hand]->referenced = 0;
+            cache->hand++;
+        }
+        else
+        {
+            evictEntry(cache);
+        }
+    }
+
+    if (cache->ringSize == cache->ringCapacity)
+    {
+        int capacity = cache->ringCapacity == 0 ? CACHE_MIN_BUCKETS : cache->ringCapacity * 2;
+        CacheEntry **ring = (CacheEntry **)statsRealloc(cache->ring, sizeof(CacheEntry *) * capacity);
+        if (ring == NULL)
+        {
+            return EXIT_FAILURE;
+        }
+        cache->ring = ring;
+        cache->ringCapacity = capacity;
+    }
+
+    CacheEntry *entry = (CacheEntry *)statsMalloc(size);
+    if (entry == NULL)
+    {
+        return EXIT_FAILURE;
+    }
+    entry->hash = hash;
+    entry->referenced = 0;
+    entry->keyLength = keyLength;
+    entry->valueLength = valueLength;
+    memcpy(entry->data, key, keyLength);
+    memcpy(entry->data + keyLength, value, valueLength);
+
+    entry->next = cache->buckets[hash & cache->mask];
+    cache->buckets[hash & cache->mask] = entry;
+    cache->ring[cache->ringSize++] = entry;
+    cache->bytes += size;
+    return EXIT_SUCCESS;
+}
+
+void freeCache(Cache *cache)
+{
+    for (int i = 0; i < cache->ringSize; i++)
+    {
+        free(cache->ring[i]);
+    }
+    free(cache->ring);
+    free(cache->buckets);
+    free(cache);
+}
@@ -0,0 +1,118 @@
+/**
+ * @file Cache.h
+ *
+ * @brief Bounded cache of the results of formulas that were already parsed.
+ *
+ * The cache maps the text of a formula to the bytes its mode wrote for it.
+ * Entries live in a hash table of chained buckets and in a ring used by the
+ * CLOCK eviction: a hit marks the entry as referenced, and when the memory cap
+ * is reached the hand of the clock evicts the first entry that was not
+ * referenced since it last passed by.
+ *
+ * @author Nicolas Constantinou
+ * @date 23/10/2024
+ */
+#ifndef Cache_h
+#define Cache_h
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+/**
+ * @brief Smallest number of buckets of a cache.
+ */
+#define CACHE_MIN_BUCKETS 1024
+
+/**
+ * @brief Expected bytes per entry, used to size the buckets from the memory cap.
+ */
+#define CACHE_ENTRY_ESTIMATE 128
+
+/**
+ * @struct CacheEntry
+ *
+ * @brief Structure of a cached formula, its key followed by its result in data.
+ */
+typedef struct cacheEntry
+{
+    struct cacheEntry *next;
+    unsigned int hash;
+    int referenced;
+    size_t keyLength;
+    size_t valueLength;
+    char data[];
+} CacheEntry;
+
+/**
+ * @struct Cache
+ *
+ * @brief Structure of a cache with its buckets, its clock ring and its counters.
+ */
+typedef struct cache
+{
+    CacheEntry **buckets;
+    CacheEntry **ring;
+    unsigned int mask;
+    int ringSize;
+    int ringCapacity;
+    int hand;
+    size_t bytes;
+    size_t limit;
+    long hits;
+    long misses;
+    long evictions;
+} Cache;
+
+/**
+ * @brief Creates an empty cache.
+ *
+ * @param cache Double pointer to the cache that will be allocated.
+ * @param limit The largest number of bytes the entries may use.
+ * @return int Returns EXIT_SUCCESS on success or EXIT_FAILURE on failure.
+ */
+int initCache(Cache **cache, size_t limit);
+
+/**
+ * @brief Looks up a formula and counts a hit or a miss.
+ *
+ * @param cache Pointer of cache.
+ * @param hash The hash of the formula from hashBytes.
+ * @param key The formula string.
+ * @param length The length of the formula.
+ * @return CacheEntry* The entry of the formula, or NULL if it is not cached.
+ */
+CacheEntry *findCache(Cache *cache, unsigned int hash, const char *key, size_t length);
+
+/**
+ * @brief Removes the entry under the hand of the clock and frees it.
+ *
+ * The last entry of the ring moves to the freed place.
+ *
+ * @param cache Pointer of cache, with at least one entry.
+ */
+void evictEntry(Cache *cache);
+
+/**
+ * @brief Stores the result of a formula, evicting old entries to stay under the limit.
+ *
+ * Results too large for a sixteenth of the limit are not stored.
+ *
+ * @param cache Pointer of cache.
+ * @param hash The hash of the formula from hashBytes.
+ * @param key The formula string.
+ * @param keyLength The length of the formula.
+ * @param value The result of the formula.
+ * @param valueLength The length of the result.
+ * @return int Returns EXIT_SUCCESS on success or EXIT_FAILURE on failure.
+ */
+int insertCache(Cache *cache, unsigned int hash, const char *key, size_t keyLength, const char *value, size_t valueLength);
+
+/**
+ * @brief Frees the cache and all its entries from the memory.
+ *
+ * @param cache Pointer of cache.
+ */
+void freeCache(Cache *cache);
+
+#endif
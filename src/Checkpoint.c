@@ -0,0 +1,146 @@
+/**
+ * @file Checkpoint.c
+ *
+ * @brief Checkpoints of --incremental runs, kept next to the output file.
+ *
+ * @author Nicolas Constantinou
+ * @date 23/10/2024
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <errno.h>
+#include <unistd.h>
+#include "Hash.h"
+#include "Bytecode.h"
+#include "Checkpoint.h"
+
+int openCheckpoint(Checkpoint **checkpoint, char *fileName, char *outFileName, PeriodicTable *table,
+                   int empirical, int mode)
+{
+    if (strcmp(fileName, STANDARD_INPUT) == 0 || strcmp(outFileName, STANDARD_STREAM) == 0)
+    {
+        printf("--incremental needs an input and an output file, not a standard stream!\n");
+        return EXIT_FAILURE;
+    }
+    (*checkpoint) = (Checkpoint *)statsCalloc(1, sizeof(Checkpoint));
+    if ((*checkpoint) == NULL)
+    {
+        printf("Could not allocate the checkpoint!\n");
+        return EXIT_FAILURE;
+    }
+    (*checkpoint)->mode = mode;
+    (*checkpoint)->empirical = empirical;
+    (*checkpoint)->table = hashTable(table);
+    (*checkpoint)->name = (char *)statsMalloc(strlen(outFileName) + 6);
+    (*checkpoint)->writeName = (char *)statsMalloc(strlen(outFileName) + 10);
+    if ((*checkpoint)->name == NULL || (*checkpoint)->writeName == NULL)
+    {
+        printf("Could not allocate the checkpoint!\n");
+        closeCheckpoint(*checkpoint);
+        (*checkpoint) = NULL;
+        return EXIT_FAILURE;
+    }
+    sprintf((*checkpoint)->name, "%s.ckpt", outFileName);
+    sprintf((*checkpoint)->writeName, "%s.ckpt.tmp", outFileName);
+
+    /* without a checkpoint the run starts from the beginning */
+    FILE *fp = fopen((*checkpoint)->name, "r");
+    if (fp == NULL && errno == ENOENT)
+    {
+        return EXIT_SUCCESS;
+    }
+    int fileMode = -1;
+    int fileEmpirical = -1;
+    unsigned int fileTable = 0;
+    unsigned int tail = 0;
+    Checkpoint *c = *checkpoint;
+    int fields = fp == NULL ? 0 : fscanf(fp, CHECKPOINT_MAGIC " mode=%d empirical=%d table=%x input=%lld lines=%lld output=%lld tail=%zu:%x",
+                                         &fileMode, &fileEmpirical, &fileTable, &c->input, &c->lines, &c->output,
+                                         &c->tailLength, &tail);
+    if (fp != NULL)
+    {
+        fclose(fp);
+    }
+    if (fields != 8 || c->input < 0 || c->lines < 0 || c->output < 0 ||
+        c->tailLength > CHECKPOINT_TAIL || (long long)c->tailLength > c->input)
+    {
+        printf("Could not read the checkpoint %s!\n", c->name);
+        closeCheckpoint(c);
+        (*checkpoint) = NULL;
+        return EXIT_FAILURE;
+    }
+    if (fileMode != mode || fileEmpirical != empirical || fileTable != c->table)
+    {
+        printf("The checkpoint %s is of another mode or periodic table!\n", c->name);
+        closeCheckpoint(c);
+        (*checkpoint) = NULL;
+        return EXIT_FAILURE;
+    }
+    c->tail = tail;
+    c->saved = c->input;
+    return EXIT_SUCCESS;
+}
+
+int resumeInput(Checkpoint *checkpoint, LineReader *reader, char *fileName)
+{
+    /* the bytes before the tail are skipped, the tail shows that the input is the same */
+    size_t before = (size_t)checkpoint->input - checkpoint->tailLength;
+    char *data = NULL;
+    if (skipBytes(reader, before) <= 0 ||
+        (checkpoint->tailLength > 0 && peekBytes(reader, checkpoint->tailLength, &data) <= 0))
+    {
+        printf("The input %s is shorter than its checkpoint!\n", fileName);
+        return EXIT_FAILURE;
+    }
+    if (checkpoint->tailLength > 0 && hashBytes(data, checkpoint->tailLength, HASH_SEED) != checkpoint->tail)
+    {
+        printf("The input %s has changed since its checkpoint!\n", fileName);
+        return EXIT_FAILURE;
+    }
+    reader->start += checkpoint->tailLength;
+    return EXIT_SUCCESS;
+}
+
+void advanceCheckpoint(Checkpoint *checkpoint, const char *block, size_t length, long long lines)
+{
+    /* a block shorter than the tail only gives its own bytes */
+    checkpoint->tailLength = length < CHECKPOINT_TAIL ? length : CHECKPOINT_TAIL;
+    checkpoint->tail = hashBytes(block + length - checkpoint->tailLength, checkpoint->tailLength, HASH_SEED);
+    checkpoint->input += (long long)length;
+    checkpoint->lines = lines;
+}
+
+int saveCheckpoint(Checkpoint *checkpoint, Output *out)
+{
+    /* the results must be on the disk before a checkpoint that counts them */
+    if (syncOutput(out) == EXIT_FAILURE)
+    {
+        return EXIT_FAILURE;
+    }
+    checkpoint->output = (long long)out->written;
+
+    FILE *fp = fopen(checkpoint->writeName, "w");
+    if (fp == NULL)
+    {
+        printf("Could not open %s!\n", checkpoint->writeName);
+        return EXIT_FAILURE;
+    }
+    int written = fprintf(fp, CHECKPOINT_MAGIC " mode=%d empirical=%d table=%08x input=%lld lines=%lld output=%lld tail=%zu:%08x\n",
+                          checkpoint->mode, checkpoint->empirical, (unsigned int)checkpoint->table, checkpoint->input,
+                          checkpoint->lines, checkpoint->output, checkpoint->tailLength, (unsigned int)checkpoint->tail);
+    int synced = fflush(fp) == 0 && fsync(fileno(fp)) == 0;
+    if (fclose(fp) != 0 || written < 0 || !synced || rename(checkpoint->writeName, checkpoint->name) != 0)
+    {
+        printf("Could not write the checkpoint %s!\n", checkpoint->name);
+        remove(checkpoint->writeName);
+        return EXIT_FAILURE;
+    }
+    checkpoint->saved = checkpoint->input;
+    return EXIT_SUCCESS;
+}
+
+void closeCheckpoint(Checkpoint *checkpoint)
+{
+    free(checkpoint->name);
+    free(checkpoint->writeName);
+    free(checkpoint);
+}
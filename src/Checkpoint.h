@@ -0,0 +1,118 @@
+/**
+ * @file Checkpoint.h
+ *
+ * @brief Checkpoints of --incremental runs, kept next to the output file.
+ *
+ * An incremental run records in OUTPUT.ckpt how far it has got: the bytes and
+ * lines of the input it has processed and the bytes of the output they gave.
+ * The next run skips the processed input, cuts the output back to the recorded
+ * length and appends the results of the rest, so a file that only grows is
+ * processed once, and an interrupted run goes on from its last checkpoint.
+ *
+ * A checkpoint is saved every CHECKPOINT_INTERVAL bytes of input and at the end
+ * of a run, after the output before it is synced to the disk. It also records
+ * the mode, the table and a hash of the last bytes it covers, so a checkpoint
+ * is refused for another mode or table, or for an input that was replaced.
+ *
+ * @author Nicolas Constantinou
+ * @date 23/10/2024
+ */
+#ifndef Checkpoint_h
+#define Checkpoint_h
+
+#include <stdint.h>
+
+#include "periodicTable.h"
+#include "Output.h"
+#include "LineReader.h"
+
+/**
+ * @brief First word of a checkpoint file.
+ */
+#define CHECKPOINT_MAGIC "PFCKPT1"
+
+/**
+ * @brief Bytes of input processed between two checkpoints.
+ */
+#define CHECKPOINT_INTERVAL (64 << 20)
+
+/**
+ * @brief Most bytes at the end of the processed input that are hashed.
+ */
+#define CHECKPOINT_TAIL 64
+
+/**
+ * @struct Checkpoint
+ *
+ * @brief The progress of an incremental run.
+ *
+ * input, lines and output are the progress of the run so far, and saved the
+ * input of the last saved checkpoint. tail is the hash of the last tailLength
+ * bytes of the processed input.
+ */
+typedef struct checkpoint
+{
+    char *name;
+    char *writeName;
+    int mode;
+    int empirical;
+    uint32_t table;
+    long long input;
+    long long lines;
+    long long output;
+    long long saved;
+    size_t tailLength;
+    uint32_t tail;
+} Checkpoint;
+
+/**
+ * @brief Opens the checkpoint of an output file, or starts a new one.
+ *
+ * @param checkpoint Double pointer to the checkpoint that will be allocated.
+ * @param fileName Name of the input file.
+ * @param outFileName Name of the output file.
+ * @param table Pointer to the periodic table of the run.
+ * @param empirical The empirical option of the run.
+ * @param mode The mode of the run.
+ * @return int EXIT_SUCCESS on success, EXIT_FAILURE on error or for a checkpoint of another run.
+ */
+int openCheckpoint(Checkpoint **checkpoint, char *fileName, char *outFileName, PeriodicTable *table,
+                   int empirical, int mode);
+
+/**
+ * @brief Skips the input that the checkpoint covers.
+ *
+ * @param checkpoint Pointer to the checkpoint.
+ * @param reader Pointer to the reader at the start of the input.
+ * @param fileName Name of the input file.
+ * @return int EXIT_SUCCESS on success, EXIT_FAILURE if the input is shorter or has changed.
+ */
+int resumeInput(Checkpoint *checkpoint, LineReader *reader, char *fileName);
+
+/**
+ * @brief Adds a processed block of input to the checkpoint.
+ *
+ * @param checkpoint Pointer to the checkpoint.
+ * @param block The block of input.
+ * @param length The length of the block.
+ * @param lines The number of lines processed so far, with the block.
+ */
+void advanceCheckpoint(Checkpoint *checkpoint, const char *block, size_t length, long long lines);
+
+/**
+ * @brief Syncs the output and saves the checkpoint in place of the older one.
+ *
+ * @param checkpoint Pointer to the checkpoint.
+ * @param out Pointer to the output.
+ * @return int EXIT_SUCCESS on success, EXIT_FAILURE on error.
+ */
+int saveCheckpoint(Checkpoint *checkpoint, Output *out);
+
+/**
+ * @brief Frees a checkpoint from the memory.
+ *
+ * @param checkpoint Pointer to the checkpoint.
+ */
+void closeCheckpoint(Checkpoint *checkpoint);
+
+#endif
@@ -0,0 +1,368 @@
+/**
+ * @file Formula.c
+ *
+ * @brief Parsing of one formula held in memory.
+ *
+ * @author Nicolas Constantinou
+ * @date 23/10/2024
+ */
+#include <limits.h>
+#include "Stack.h"
+#include "periodicTable.h"
+#include "Output.h"
+#include "Lexer.h"
+#include "Formula.h"
+
+int checkBalance(char *buffer, size_t length)
+{
+    int depth = 0;
+    for (size_t i = 0; i < length; i++)
+    {
+        if (buffer[i] == '(')
+        {
+            depth++;
+        }
+        else if (buffer[i] == ')' && --depth < 0)
+        {
+            return EXIT_FAILURE;
+        }
+    }
+    if (depth != 0)
+    {
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+int protonNumber(long long *counts, PeriodicTable *table, long long *protons)
+{
+    long long total = 0;
+    for (int i = 0; i < table->size; i++)
+    {
+        long long protonsOfElement = 0;
+        if (multiplyChecked(counts[i], table->array[i].periodicNum, &protonsOfElement) == EXIT_FAILURE ||
+            addChecked(total, protonsOfElement, &total) == EXIT_FAILURE)
+        {
+            return EXIT_FAILURE;
+        }
+    }
+    *protons = total;
+    return EXIT_SUCCESS;
+}
+
+int printProtonNumber(long long *counts, PeriodicTable *table, Output *out)
+{
+    long long protons = 0;
+    if (protonNumber(counts, table, &protons) == EXIT_FAILURE)
+    {
+        return EXIT_FAILURE;
+    }
+    return writeNumber(out, protons);
+}
+
+int countAtoms(long long *counts, PeriodicTable *table, long long *atoms)
+{
+    long long total = 0;
+    for (int i = 0; i < table->size; i++)
+    {
+        if (addChecked(total, counts[i], &total) == EXIT_FAILURE)
+        {
+            return EXIT_FAILURE;
+        }
+    }
+    *atoms = total;
+    return EXIT_SUCCESS;
+}
+
+int multiplyChecked(long long a, long long b, long long *result)
+{
+#ifdef __GNUC__
+    return __builtin_mul_overflow(a, b, result) ? EXIT_FAILURE : EXIT_SUCCESS;
+#else
+    /* the counts and multipliers are never negative */
+    if (a < 0 || b < 0 || (b != 0 && a > LLONG_MAX / b))
+    {
+        return EXIT_FAILURE;
+    }
+    *result = a * b;
+    return EXIT_SUCCESS;
+#endif
+}
+
+int addChecked(long long a, long long b, long long *result)
+{
+#ifdef __GNUC__
+    return __builtin_add_overflow(a, b, result) ? EXIT_FAILURE : EXIT_SUCCESS;
+#else
+    if (a < 0 || b < 0 || a > LLONG_MAX - b)
+    {
+        return EXIT_FAILURE;
+    }
+    *result = a + b;
+    return EXIT_SUCCESS;
+#endif
+}
+
+int printHillFormula(long long *counts, PeriodicTable *table, int empirical, Output *out)
+{
+    long long divisor = 0;
+    if (empirical)
+    {
+        for (int i = 0; i < table->size; i++)
+        {
+            long long a = counts[i];
+            long long b = divisor;
+            while (b != 0)
+            {
+                long long r = a % b;
+                a = b;
+                b = r;
+            }
+            divisor = a;
+        }
+    }
+    if (divisor <= 0)
+    {
+        divisor = 1;
+    }
+
+    /* with carbon, carbon and hydrogen come first, then the rest alphabetically */
+    int carbon = findMoleculeIndex("C", table);
+    int hydrogen = findMoleculeIndex("H", table);
+    if (carbon < 0 || counts[carbon] == 0)
+    {
+        carbon = -1;
+        hydrogen = -1;
+    }
+    int first[2];
+    first[0] = carbon;
+    first[1] = hydrogen;
+    for (int k = 0; k < 2 + table->orderSize; k++)
+    {
+        int i = k < 2 ? first[k] : table->order[k - 2];
+        if (i < 0 || counts[i] == 0 || (k >= 2 && (i == carbon || i == hydrogen)))
+        {
+            continue;
+        }
+        if (writeString(out, table->array[i].name) == EXIT_FAILURE)
+        {
+            return EXIT_FAILURE;
+        }
+        if (counts[i] / divisor != 1 && writeInteger(out, counts[i] / divisor) == EXIT_FAILURE)
+        {
+            return EXIT_FAILURE;
+        }
+    }
+    return writeOutput(out, "\n", 1);
+}
+
+int tokenizeFormula(char *buffer, size_t length, TokenStack *tokens, TokenStack *opens, PeriodicTable *table)
+{
+    tokens->size = 0;
+    opens->size = 0;
+
+    /* bytes before next belong to a symbol or a number already read */
+    size_t next = 0;
+    LexMasks masks;
+    for (size_t start = 0; start < length; start += LEXER_WINDOW)
+    {
+        classifyAt(buffer, length, start, &masks);
+        uint64_t events = masks.upper | masks.lower | masks.digit | masks.open | masks.close;
+        size_t stop = start + LEXER_WINDOW;
+
+        while (events != 0)
+        {
+            int bit = lowestBit(events);
+            uint64_t mask = (uint64_t)1 << bit;
+            size_t i = start + bit;
+            events &= events - 1;
+            if (i < next)
+            {
+                continue;
+            }
+
+            if (masks.upper & mask)
+            {
+                next = i + 1 + (bit + 1 < LEXER_WINDOW ? countRun(masks.lower, bit + 1) : 0);
+                while (next == stop && next < length && buffer[next] >= 'a' && buffer[next] <= 'z')
+                {
+                    next++;
+                    stop++;
+                }
+                int index = findSymbolIndex(buffer + i, next - i, table);
+                if (index < 0 || pushToken(tokens, index, 1) == EXIT_FAILURE)
+                {
+                    return EXIT_FAILURE;
+                }
+            }
+
+            else if (masks.digit & mask)
+            {
+                next = i + countRun(masks.digit, bit);
+                while (next == stop && next < length && buffer[next] >= '0' && buffer[next] <= '9')
+                {
+                    next++;
+                    stop++;
+                }
+                int times = 0;
+                for (size_t digit = i; digit < next; digit++)
+                {
+                    if (times > (INT_MAX - (buffer[digit] - '0')) / 10)
+                    {
+                        return EXIT_FAILURE;
+                    }
+                    times = times * 10 + (buffer[digit] - '0');
+                }
+                /* the multiplier repeats the last element or group once more times - 1 */
+                if (tokens->size == 0 || tokens->array[tokens->size - 1].id == TOKEN_OPEN)
+                {
+                    return EXIT_FAILURE;
+                }
+                long long count = (long long)tokens->array[tokens->size - 1].count + times - 1;
+                if (count < 0 || count > INT_MAX)
+                {
+                    return EXIT_FAILURE;
+                }
+                tokens->array[tokens->size - 1].count = (int)count;
+            }
+
+            else if (masks.open & mask)
+            {
+                if (pushToken(opens, tokens->size, 0) == EXIT_FAILURE || pushToken(tokens, TOKEN_OPEN, 0) == EXIT_FAILURE)
+                {
+                    return EXIT_FAILURE;
+                }
+            }
+
+            else if (masks.close & mask)
+            {
+                if (opens->size == 0)
+                {
+                    return EXIT_FAILURE;
+                }
+                int open = opens->array[--opens->size].id;
+                if (open == tokens->size - 1)
+                {
+                    return EXIT_FAILURE;
+                }
+                tokens->array[open].count = tokens->size;
+                if (pushToken(tokens, TOKEN_CLOSE, 1) == EXIT_FAILURE)
+                {
+                    return EXIT_FAILURE;
+                }
+            }
+
+            else
+            {
+                /* a lowercase letter that does not follow an uppercase one */
+                return EXIT_FAILURE;
+            }
+        }
+    }
+
+    if (opens->size != 0)
+    {
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+int countTokens(TokenStack *tokens, long long *counts, PeriodicTable *table)
+{
+    memset(counts, 0, sizeof(long long) * table->size);
+    long long multiplier = 1;
+    unsigned long long total = 0;
+    int i = 0;
+    while (i < tokens->size)
+    {
+        Token *token = &tokens->array[i];
+        if (token->id == TOKEN_OPEN)
+        {
+            int times = tokens->array[token->count].count;
+            if (times <= 0)
+            {
+                i = token->count + 1;
+                continue;
+            }
+            if (multiplyChecked(multiplier, times, &multiplier) == EXIT_FAILURE)
+            {
+                return EXIT_FAILURE;
+            }
+        }
+        else if (token->id == TOKEN_CLOSE)
+        {
+            /* the multiplier of the group was a factor of the product, so it divides exactly */
+            multiplier /= token->count;
+        }
+        else
+        {
+            /* a count below 2^31 times a multiplier below 2^31 cannot overflow */
+            long long atoms = 0;
+            if (multiplier <= INT_MAX)
+            {
+                atoms = token->count * multiplier;
+            }
+            else if (multiplyChecked(token->count, multiplier, &atoms) == EXIT_FAILURE)
+            {
+                return EXIT_FAILURE;
+            }
+            /* no count can overflow while the total of all of them fits */
+            total += (unsigned long long)atoms;
+            if (total > LLONG_MAX)
+            {
+                return EXIT_FAILURE;
+            }
+            counts[token->id] += atoms;
+        }
+        i++;
+    }
+    return EXIT_SUCCESS;
+}
+
+int printExpansion(TokenStack *tokens, TokenStack *frames, PeriodicTable *table, Output *out)
+{
+    frames->size = 0;
+    int i = 0;
+    while (i < tokens->size)
+    {
+        Token *token = &tokens->array[i];
+        if (token->id == TOKEN_OPEN)
+        {
+            int times = tokens->array[token->count].count;
+            if (times <= 0)
+            {
+                i = token->count + 1;
+                continue;
+            }
+            /* a frame keeps the open parenthesis and the repeats left */
+            if (pushToken(frames, i, times) == EXIT_FAILURE)
+            {
+                return EXIT_FAILURE;
+            }
+        }
+        else if (token->id == TOKEN_CLOSE)
+        {
+            Token *frame = &frames->array[frames->size - 1];
+            if (--frame->count > 0)
+            {
+                i = frame->id + 1;
+                continue;
+            }
+            frames->size--;
+        }
+        else
+        {
+            char *name = table->array[token->id].name;
+            size_t size = strlen(name);
+            for (int count = 0; count < token->count; count++)
+            {
+                if (writeOutput(out, name, size) == EXIT_FAILURE)
+                {
+                    return EXIT_FAILURE;
+                }
+            }
+        }
+        i++;
+    }
+    return writeOutput(out, "\n", 1);
+}
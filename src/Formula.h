@@ -0,0 +1,149 @@
+/**
+ * @file Formula.h
+ *
+ * @brief Parsing of one formula held in memory.
+ *
+ * This file contains function prototypes to read a formula into tokens, count
+ * its elements, compute its proton number and write its expanded and Hill
+ * formulas. They use no files and print nothing, so both the program and the
+ * library are built on them.
+ *
+ * @author Nicolas Constantinou
+ * @date 23/10/2024
+ */
+#ifndef Formula_h
+#define Formula_h
+
+#include "Stack.h"
+#include "periodicTable.h"
+#include "Output.h"
+
+/**
+ * @brief Checks if parentheses in a formula are balanced by counting the depth.
+ *
+ * This needs no stack, so it is cheap enough to run on every line inside the
+ * parsing loop.
+ *
+ * @param buffer The chemical formula string.
+ * @param length The length of the formula.
+ * @return int EXIT_SUCCESS if balanced, EXIT_FAILURE if unbalanced.
+ */
+int checkBalance(char *buffer, size_t length);
+
+/**
+ * @brief Computes the total proton number of an element count array.
+ *
+ * @param counts The count of every element, indexed like the periodic table.
+ * @param table Pointer to the periodic table.
+ * @param protons Pointer that receives the proton number.
+ * @return int EXIT_SUCCESS on success, EXIT_FAILURE if the proton number does not fit in 64 bits.
+ */
+int protonNumber(long long *counts, PeriodicTable *table, long long *protons);
+
+/**
+ * @brief Writes the total proton number of an element count array to the output.
+ *
+ * @param counts The count of every element, indexed like the periodic table.
+ * @param table Pointer to the periodic table.
+ * @param out Pointer to the output for results.
+ * @return int EXIT_SUCCESS on success, EXIT_FAILURE on error or overflow.
+ */
+int printProtonNumber(long long *counts, PeriodicTable *table, Output *out);
+
+/**
+ * @brief Computes the total number of atoms of an element count array.
+ *
+ * @param counts The count of every element, indexed like the periodic table.
+ * @param table Pointer to the periodic table.
+ * @param atoms Pointer that receives the number of atoms.
+ * @return int EXIT_SUCCESS on success, EXIT_FAILURE if the number does not fit in 64 bits.
+ */
+int countAtoms(long long *counts, PeriodicTable *table, long long *atoms);
+
+/**
+ * @brief Multiplies two numbers, failing instead of overflowing.
+ *
+ * @param a The first number.
+ * @param b The second number.
+ * @param result Pointer that receives the product, may be the address of a.
+ * @return int EXIT_SUCCESS on success, EXIT_FAILURE if the product does not fit in a long long.
+ */
+int multiplyChecked(long long a, long long b, long long *result);
+
+/**
+ * @brief Adds two numbers, failing instead of overflowing.
+ *
+ * @param a The first number.
+ * @param b The second number.
+ * @param result Pointer that receives the sum, may be the address of a.
+ * @return int EXIT_SUCCESS on success, EXIT_FAILURE if the sum does not fit in a long long.
+ */
+int addChecked(long long a, long long b, long long *result);
+
+/**
+ * @brief Writes an element count array to the output in Hill notation.
+ *
+ * When carbon is present it comes first and hydrogen second, then all other
+ * elements follow in alphabetical order; without carbon all elements are in
+ * alphabetical order. Counts of 1 are not written.
+ *
+ * @param counts The count of every element, indexed like the periodic table.
+ * @param table Pointer to the periodic table.
+ * @param empirical Non zero to divide all counts by their greatest common divisor.
+ * @param out Pointer to the output for results.
+ * @return int EXIT_SUCCESS on success, EXIT_FAILURE on error.
+ */
+int printHillFormula(long long *counts, PeriodicTable *table, int empirical, Output *out);
+
+/**
+ * @brief Turns a formula string into tokens without expanding it.
+ *
+ * Every element becomes one token with its repeat count and every group an open
+ * and a closing token, so the number of tokens is at most the length of the formula.
+ * A multiplier is folded into the count of the element or closing token before it,
+ * and a multiplier larger than INT_MAX makes the formula invalid.
+ * The characters are classified with classifyFormula and only the bits of letters,
+ * digits and parentheses are visited, so the time is linear in the length.
+ * A formula that is read without error has balanced parentheses.
+ *
+ * @param buffer The formula string.
+ * @param length The length of the formula.
+ * @param tokens Pointer to the token stack that receives the tokens, emptied first.
+ * @param opens Pointer to a token stack used as work space for the open parentheses.
+ * @param table Pointer to the periodic table structure.
+ * @return int EXIT_SUCCESS on success, EXIT_FAILURE on error.
+ */
+int tokenizeFormula(char *buffer, size_t length, TokenStack *tokens, TokenStack *opens, PeriodicTable *table);
+
+/**
+ * @brief Computes the element counts of a formula from its tokens.
+ *
+ * The tokens are walked once, keeping the product of the multipliers of the open
+ * groups, so groups are never repeated. A closing token divides the product by
+ * its multiplier again. Every product and sum is checked, so a formula with
+ * more atoms than a long long holds fails instead of giving a wrong count.
+ *
+ * @param tokens Pointer to the token stack filled by tokenizeFormula.
+ * @param counts Array of table->size counts that receives the result.
+ * @param table Pointer to the periodic table structure.
+ * @return int EXIT_SUCCESS on success, EXIT_FAILURE on overflow.
+ */
+int countTokens(TokenStack *tokens, long long *counts, PeriodicTable *table);
+
+/**
+ * @brief Streams the expanded formula of the tokens to the output.
+ *
+ * The tokens are walked in order, jumping back to the start of a group while it
+ * has repeats left, and every atom is written straight to the output. Only one
+ * frame per open group is kept, so memory depends on the nesting depth and not
+ * on the size of the expansion.
+ *
+ * @param tokens Pointer to the token stack filled by tokenizeFormula.
+ * @param frames Pointer to a token stack used as work space for the open groups.
+ * @param table Pointer to the periodic table structure.
+ * @param out Pointer to the output to write the formula.
+ * @return int EXIT_SUCCESS on success, EXIT_FAILURE on error.
+ */
+int printExpansion(TokenStack *tokens, TokenStack *frames, PeriodicTable *table, Output *out);
+
+#endif
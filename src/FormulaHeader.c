@@ -0,0 +1,265 @@
+/**
+ * @file FormulaHeader.c
+ *
+ * @brief Generator of C headers with the results of known formulas.
+ *
+ * @author Nicolas Constantinou
+ * @date 23/10/2024
+ */
+#include <ctype.h>
+#include "Stack.h"
+#include "periodicTable.h"
+#include "Output.h"
+#include "LineReader.h"
+#include "Balance.h"
+#include "ParseFormula.h"
+#include "FormulaLibrary.h"
+#include "Mass.h"
+#include "FormulaHeader.h"
+
+int writeFormulaHeader(char *fileName, char *outFileName, PeriodicTable *table)
+{
+    LineReader *reader = NULL;
+    if (openReader(&reader, fileName) == EXIT_FAILURE)
+    {
+        return EXIT_FAILURE;
+    }
+    FormulaParser *parser = NULL;
+    if (initFormulaParser(&parser, table) != FORMULA_OK)
+    {
+        closeReader(reader);
+        return EXIT_FAILURE;
+    }
+    /* the header only replaces an older one when every formula is valid */
+    Output *out = NULL;
+    if (openOutput(&out, outFileName, 1) == EXIT_FAILURE)
+    {
+        freeFormulaParser(parser);
+        closeReader(reader);
+        return EXIT_FAILURE;
+    }
+
+    char guard[HEADER_NAME_SIZE];
+    char text[256];
+    headerGuard(outFileName, guard);
+    snprintf(text, sizeof(text),
+             " */\n#ifndef %s\n#define %s\n\n"
+             "#ifndef FORMULA_ELEMENTS\n#define FORMULA_ELEMENTS %d\n#endif\n",
+             guard, guard, table->size);
+    int status = EXIT_SUCCESS;
+    if (writeString(out, "/* Generated by parseFormula -header from ") == EXIT_FAILURE ||
+        writeString(out, fileName) == EXIT_FAILURE ||
+        writeString(out, ", do not edit.") == EXIT_FAILURE ||
+        writeString(out, text) == EXIT_FAILURE)
+    {
+        status = EXIT_FAILURE;
+    }
+
+    /* masses are only written when the table gives them */
+    int masses = hasMasses(table);
+
+    HeaderName *names = NULL;
+    int count = 0;
+    int capacity = 0;
+    char *line = NULL;
+    size_t length = 0;
+    long lineNumber = 0;
+    int more = 0;
+    while (status == EXIT_SUCCESS && (more = nextLine(reader, &line, &length)) == 1)
+    {
+        lineNumber++;
+        while (length > 0 && isspace((unsigned char)line[length - 1]))
+        {
+            length--;
+        }
+        if (length == 0 || line[0] == '#')
+        {
+            continue;
+        }
+        char name[HEADER_NAME_SIZE];
+        char *formula = NULL;
+        size_t formulaLength = 0;
+        if (splitHeaderLine(line, length, name, &formula, &formulaLength) == EXIT_FAILURE)
+        {
+            printf("Expected a name and a formula in line: %ld\n", lineNumber);
+            status = EXIT_FAILURE;
+            break;
+        }
+        /* a second definition of the macros would only warn, and the last one would win */
+        long first = findHeaderName(names, count, name);
+        if (first > 0)
+        {
+            printf("Name %s in line: %ld was already given in line: %ld\n", name, lineNumber, first);
+            status = EXIT_FAILURE;
+            break;
+        }
+        if (count == capacity)
+        {
+            int grown = capacity > 0 ? 2 * capacity : 64;
+            HeaderName *array = (HeaderName *)statsRealloc(names, sizeof(HeaderName) * grown);
+            if (array == NULL)
+            {
+                printf("Could not allocate the names of the header!\n");
+                status = EXIT_FAILURE;
+                break;
+            }
+            names = array;
+            capacity = grown;
+        }
+        strcpy(names[count].name, name);
+        names[count].line = lineNumber;
+        count++;
+        int result = parseCounts(parser, formula, formulaLength, parser->counts);
+        if (result != FORMULA_OK)
+        {
+            printf("Not valid formula %s in line: %ld, %s\n", name, lineNumber, formulaError(result));
+            status = EXIT_FAILURE;
+            break;
+        }
+        status = writeHeaderFormula(out, name, formula, formulaLength, parser, masses);
+    }
+    if (more < 0)
+    {
+        status = EXIT_FAILURE;
+    }
+    if (status == EXIT_SUCCESS)
+    {
+        status = writeString(out, "\n#endif\n");
+    }
+
+    if (closeOutput(out, status) == EXIT_FAILURE)
+    {
+        status = EXIT_FAILURE;
+    }
+    free(names);
+    freeFormulaParser(parser);
+    closeReader(reader);
+    return status;
+}
+
+int splitHeaderLine(char *line, size_t length, char *name, char **formula, size_t *formulaLength)
+{
+    size_t i = 0;
+    while (i < length && (isalnum((unsigned char)line[i]) || line[i] == '_'))
+    {
+        i++;
+    }
+    if (i == 0 || i >= HEADER_NAME_SIZE || isdigit((unsigned char)line[0]))
+    {
+        return EXIT_FAILURE;
+    }
+    memcpy(name, line, i);
+    name[i] = '\0';
+
+    size_t start = i;
+    while (start < length && (line[start] == ' ' || line[start] == '\t'))
+    {
+        start++;
+    }
+    if (start == i || start == length)
+    {
+        return EXIT_FAILURE;
+    }
+    *formula = line + start;
+    *formulaLength = length - start;
+    return EXIT_SUCCESS;
+}
+
+long findHeaderName(HeaderName *names, int count, char *name)
+{
+    for (int i = 0; i < count; i++)
+    {
+        if (strcmp(names[i].name, name) == 0)
+        {
+            return names[i].line;
+        }
+    }
+    return 0;
+}
+
+int writeHeaderFormula(Output *out, char *name, char *formula, size_t length, FormulaParser *parser, int masses)
+{
+    PeriodicTable *table = parser->table;
+    char text[256];
+
+    snprintf(text, sizeof(text), "\n#define %s_FORMULA \"", name);
+    if (writeString(out, text) == EXIT_FAILURE)
+    {
+        return EXIT_FAILURE;
+    }
+    /* the parser skips characters it does not know, a quote must still be escaped */
+    for (size_t i = 0; i < length; i++)
+    {
+        if ((formula[i] == '"' || formula[i] == '\\') && writeOutput(out, "\\", 1) == EXIT_FAILURE)
+        {
+            return EXIT_FAILURE;
+        }
+        if (writeOutput(out, formula + i, 1) == EXIT_FAILURE)
+        {
+            return EXIT_FAILURE;
+        }
+    }
+
+    long long protons = 0;
+    if (protonNumber(parser->counts, table, &protons) == EXIT_FAILURE)
+    {
+        printf("Too many atoms in formula %s!\n", name);
+        return EXIT_FAILURE;
+    }
+    snprintf(text, sizeof(text), "\"\n#define %s_PROTONS %lldLL\n", name, protons);
+    if (writeString(out, text) == EXIT_FAILURE)
+    {
+        return EXIT_FAILURE;
+    }
+
+    if (masses)
+    {
+        /* 17 digits give back the same double as the masses computed at run time */
+        double results[2];
+        computeMasses(parser->counts, 1, table->size, table->masses, results);
+        snprintf(text, sizeof(text), "#define %s_AVERAGE_MASS %#.17g\n#define %s_EXACT_MASS %#.17g\n",
+                 name, results[0], name, results[1]);
+        if (writeString(out, text) == EXIT_FAILURE)
+        {
+            return EXIT_FAILURE;
+        }
+    }
+
+    snprintf(text, sizeof(text), "#define %s_COUNTS {", name);
+    if (writeString(out, text) == EXIT_FAILURE)
+    {
+        return EXIT_FAILURE;
+    }
+    int first = 1;
+    for (int i = 0; i < table->size; i++)
+    {
+        if (parser->counts[i] == 0)
+        {
+            continue;
+        }
+        snprintf(text, sizeof(text), "%s[%d] = %lldLL /* %s */", first ? "" : ", ", i, parser->counts[i], table->array[i].name);
+        if (writeString(out, text) == EXIT_FAILURE)
+        {
+            return EXIT_FAILURE;
+        }
+        first = 0;
+    }
+    /* an empty initializer is not valid C99 */
+    return writeString(out, first ? "0}\n" : "}\n");
+}
+
+void headerGuard(char *fileName, char *guard)
+{
+    char *base = strrchr(fileName, '/');
+    base = base == NULL ? fileName : base + 1;
+    int size = 0;
+    if (isdigit((unsigned char)base[0]))
+    {
+        guard[size++] = '_';
+    }
+    for (int i = 0; base[i] != '\0' && size < HEADER_NAME_SIZE - 1; i++)
+    {
+        guard[size++] = isalnum((unsigned char)base[i]) ? (char)toupper((unsigned char)base[i]) : '_';
+    }
+    guard[size] = '\0';
+}
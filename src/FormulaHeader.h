@@ -0,0 +1,107 @@
+/**
+ * @file FormulaHeader.h
+ *
+ * @brief Generator of C headers with the results of known formulas.
+ *
+ * C has no compile time evaluation of functions, so formulas that are known
+ * when the program is built are evaluated by the generator instead. Every line
+ * of the input gives a name and a formula, e.g. "WATER H2O"; empty lines and
+ * lines starting with # are skipped. The header has, for every formula,
+ * constant macros with the formula, its proton number, its masses when the
+ * table gives them, and the initializer of an array with the count of every
+ * element in the order of the table:
+ *
+ *     #define WATER_FORMULA "H2O"
+ *     #define WATER_PROTONS 10LL
+ *     #define WATER_AVERAGE_MASS 18.015000000000001
+ *     #define WATER_EXACT_MASS 18.010564679999998
+ *     #define WATER_COUNTS {[0] = 2LL, [7] = 1LL}
+ *
+ * so that static const long long water[FORMULA_ELEMENTS] = WATER_COUNTS; is built
+ * by the compiler and the program does no parsing for these formulas.
+ *
+ * A formula that the parser does not accept, or a name given twice, stops the
+ * generator without writing the header, so the build that needs the header fails.
+ *
+ * @author Nicolas Constantinou
+ * @date 23/10/2024
+ */
+#ifndef FormulaHeader_h
+#define FormulaHeader_h
+
+#include "periodicTable.h"
+#include "Output.h"
+#include "FormulaLibrary.h"
+
+/**
+ * @brief Longest name of a formula in the input of the generator.
+ */
+#define HEADER_NAME_SIZE 64
+
+/**
+ * @struct HeaderName
+ *
+ * @brief A name already written to the header and the line it was given in.
+ */
+typedef struct headerName
+{
+    char name[HEADER_NAME_SIZE];
+    long line;
+} HeaderName;
+
+/**
+ * @brief Writes the header of the formulas of a file.
+ *
+ * @param fileName Name of the input file with a name and a formula in every line.
+ * @param outFileName Name of the header to write.
+ * @param table Pointer to the periodic table.
+ * @return int EXIT_SUCCESS on success, EXIT_FAILURE on error or on an invalid line.
+ */
+int writeFormulaHeader(char *fileName, char *outFileName, PeriodicTable *table);
+
+/**
+ * @brief Splits a line of the input of the generator into its name and formula.
+ *
+ * @param line The line, without a new line.
+ * @param length The length of the line.
+ * @param name Buffer of HEADER_NAME_SIZE bytes that receives the name.
+ * @param formula Pointer that receives the first character of the formula.
+ * @param formulaLength Pointer that receives the length of the formula.
+ * @return int EXIT_SUCCESS on success, EXIT_FAILURE if the name is not a C identifier or there is no formula.
+ */
+int splitHeaderLine(char *line, size_t length, char *name, char **formula, size_t *formulaLength);
+
+/**
+ * @brief Looks for a name among the names already written to the header.
+ *
+ * The input of the generator is small, so the names are searched in order.
+ *
+ * @param names The names already written.
+ * @param count The number of names.
+ * @param name The name to look for.
+ * @return long The line the name was given in, or 0 if it is new.
+ */
+long findHeaderName(HeaderName *names, int count, char *name);
+
+/**
+ * @brief Writes the macros and the counts of one formula.
+ *
+ * @param out Pointer to the header.
+ * @param name The name of the formula.
+ * @param formula The formula.
+ * @param length The length of the formula.
+ * @param parser Pointer to the parser, with the counts of the formula.
+ * @param masses Non zero to write the masses.
+ * @return int EXIT_SUCCESS on success, EXIT_FAILURE on error.
+ */
+int writeHeaderFormula(Output *out, char *name, char *formula, size_t length, FormulaParser *parser, int masses);
+
+/**
+ * @brief Makes the include guard of a header from its file name.
+ *
+ * @param fileName Name of the header.
+ * @param guard Buffer of HEADER_NAME_SIZE bytes that receives the guard.
+ */
+void headerGuard(char *fileName, char *guard);
+
+#endif
@@ -0,0 +1,213 @@
+/**
+ * @file FormulaLibrary.c
+ *
+ * @brief Reentrant library interface of the formula parser.
+ *
+ * @author Nicolas Constantinou
+ * @date 23/10/2024
+ */
+#include <limits.h>
+#include <stdint.h>
+#include "Stack.h"
+#include "periodicTable.h"
+#include "Output.h"
+#include "Formula.h"
+#include "Mass.h"
+#include "FormulaLibrary.h"
+
+int initFormulaParser(FormulaParser **parser, PeriodicTable *table)
+{
+    (*parser) = (FormulaParser *)statsCalloc(1, sizeof(FormulaParser));
+    if ((*parser) == NULL)
+    {
+        return FORMULA_NO_MEMORY;
+    }
+    (*parser)->table = table;
+    (*parser)->counts = (long long *)statsMalloc(sizeof(long long) * table->size);
+    if ((*parser)->counts == NULL)
+    {
+        free(*parser);
+        (*parser) = NULL;
+        return FORMULA_NO_MEMORY;
+    }
+    return FORMULA_OK;
+}
+
+void freeFormulaParser(FormulaParser *parser)
+{
+    free(parser->tokens.array);
+    free(parser->frames.array);
+    free(parser->counts);
+    free(parser);
+}
+
+int readFormula(FormulaParser *parser, const char *formula, size_t length)
+{
+    if (length >= INT_MAX)
+    {
+        return FORMULA_INVALID;
+    }
+    /* a formula of length bytes has at most length tokens and open groups */
+    parser->tokens.size = 0;
+    parser->frames.size = 0;
+    if (reserveTokens(&parser->tokens, (int)length + 1) == EXIT_FAILURE ||
+        reserveTokens(&parser->frames, (int)length + 1) == EXIT_FAILURE)
+    {
+        return FORMULA_NO_MEMORY;
+    }
+    /* the formula is only read, tokenizeFormula takes the buffers of the program */
+    if (tokenizeFormula((char *)formula, length, &parser->tokens, &parser->frames, parser->table) == EXIT_FAILURE)
+    {
+        return checkBalance((char *)formula, length) == EXIT_FAILURE ? FORMULA_UNBALANCED : FORMULA_INVALID;
+    }
+    return FORMULA_OK;
+}
+
+int parseCounts(FormulaParser *parser, const char *formula, size_t length, long long *counts)
+{
+    int status = readFormula(parser, formula, length);
+    if (status != FORMULA_OK)
+    {
+        return status;
+    }
+    if (countTokens(&parser->tokens, counts, parser->table) == EXIT_FAILURE)
+    {
+        return FORMULA_TOO_LARGE;
+    }
+    return FORMULA_OK;
+}
+
+int parseProtonNumber(FormulaParser *parser, const char *formula, size_t length, long long *protons)
+{
+    int status = parseCounts(parser, formula, length, parser->counts);
+    if (status != FORMULA_OK)
+    {
+        return status;
+    }
+    if (protonNumber(parser->counts, parser->table, protons) == EXIT_FAILURE)
+    {
+        return FORMULA_TOO_LARGE;
+    }
+    return FORMULA_OK;
+}
+
+int parseMass(FormulaParser *parser, const char *formula, size_t length, double *averageMass, double *exactMass)
+{
+    PeriodicTable *table = parser->table;
+    if (!hasMasses(table))
+    {
+        return FORMULA_NO_MASSES;
+    }
+    int status = parseCounts(parser, formula, length, parser->counts);
+    if (status != FORMULA_OK)
+    {
+        return status;
+    }
+    double results[2];
+    computeMasses(parser->counts, 1, table->size, table->masses, results);
+    *averageMass = results[0];
+    *exactMass = results[1];
+    return FORMULA_OK;
+}
+
+int parseExpansion(FormulaParser *parser, const char *formula, size_t length, char *buffer, size_t size, size_t *needed)
+{
+    int status = parseCounts(parser, formula, length, parser->counts);
+    if (status != FORMULA_OK)
+    {
+        return status;
+    }
+
+    /* the counts give the exact length before anything is written */
+    long long total = 1;
+    for (int i = 0; i < parser->table->size; i++)
+    {
+        long long bytes = 0;
+        if (multiplyChecked(parser->counts[i], (long long)strlen(parser->table->array[i].name), &bytes) == EXIT_FAILURE ||
+            addChecked(total, bytes, &total) == EXIT_FAILURE)
+        {
+            return FORMULA_TOO_LARGE;
+        }
+    }
+    if ((unsigned long long)total > SIZE_MAX)
+    {
+        return FORMULA_TOO_LARGE;
+    }
+    if (needed != NULL)
+    {
+        *needed = (size_t)total;
+    }
+    if ((size_t)total > size)
+    {
+        return FORMULA_NO_SPACE;
+    }
+
+    /* printExpansion ends the line with a new line, which becomes the terminator */
+    Output out;
+    initFixedOutput(&out, buffer, size);
+    if (printExpansion(&parser->tokens, &parser->frames, parser->table, &out) == EXIT_FAILURE)
+    {
+        return FORMULA_NO_SPACE;
+    }
+    buffer[out.size - 1] = '\0';
+    return FORMULA_OK;
+}
+
+int parseHillFormula(FormulaParser *parser, const char *formula, size_t length, int empirical, char *buffer, size_t size, size_t *needed)
+{
+    int status = parseCounts(parser, formula, length, parser->counts);
+    if (status != FORMULA_OK)
+    {
+        return status;
+    }
+
+    /* every element takes its symbol and at most the digits of a long long */
+    size_t bound = 1;
+    for (int i = 0; i < parser->table->size; i++)
+    {
+        if (parser->counts[i] != 0)
+        {
+            bound += strlen(parser->table->array[i].name) + 20;
+        }
+    }
+
+    Output out;
+    initFixedOutput(&out, buffer, size);
+    if (printHillFormula(parser->counts, parser->table, empirical, &out) == EXIT_FAILURE)
+    {
+        if (needed != NULL)
+        {
+            *needed = bound;
+        }
+        return FORMULA_NO_SPACE;
+    }
+    buffer[out.size - 1] = '\0';
+    if (needed != NULL)
+    {
+        *needed = out.size;
+    }
+    return FORMULA_OK;
+}
+
+const char *formulaError(int code)
+{
+    switch (code)
+    {
+    case FORMULA_OK:
+        return "no error";
+    case FORMULA_INVALID:
+        return "invalid formula";
+    case FORMULA_UNBALANCED:
+        return "parentheses not balanced";
+    case FORMULA_NO_SPACE:
+        return "buffer too small";
+    case FORMULA_NO_MEMORY:
+        return "out of memory";
+    case FORMULA_NO_MASSES:
+        return "the periodic table has no masses";
+    case FORMULA_TOO_LARGE:
+        return "too many atoms";
+    default:
+        return "unknown error";
+    }
+}
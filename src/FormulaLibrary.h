@@ -0,0 +1,152 @@
+/**
+ * @file FormulaLibrary.h
+ *
+ * @brief Reentrant library interface of the formula parser.
+ *
+ * The library parses one formula held in memory into buffers of the caller,
+ * without files and without printing anything. A periodic table is loaded
+ * once, with getTable, getDefaultTable or mapTable, and is only read by the
+ * library, so any number of threads may share it. Every thread needs a
+ * FormulaParser of its own, which keeps the work space of its formulas.
+ *
+ * The library is built by the library target of the makefile into
+ * libformula.a and libformula.so, from the sources of the program it needs
+ * compiled with PARSE_FORMULA_LIBRARY. Only the functions marked FORMULA_API
+ * are exported, see Library.h.
+ *
+ * @author Nicolas Constantinou
+ * @date 23/10/2024
+ */
+#ifndef FormulaLibrary_h
+#define FormulaLibrary_h
+
+#include "Stack.h"
+#include "periodicTable.h"
+
+#define FORMULA_OK 0
+#define FORMULA_INVALID 1
+#define FORMULA_UNBALANCED 2
+#define FORMULA_NO_SPACE 3
+#define FORMULA_NO_MEMORY 4
+#define FORMULA_NO_MASSES 5
+#define FORMULA_TOO_LARGE 6
+
+/**
+ * @struct FormulaParser
+ *
+ * @brief Work space of the formulas parsed by one thread.
+ *
+ * The stacks hold the tokens of the last formula and the open groups. Their
+ * room grows with the longest formula parsed and is kept for the next ones.
+ */
+typedef struct formulaParser
+{
+    PeriodicTable *table;
+    TokenStack tokens;
+    TokenStack frames;
+    long long *counts;
+} FormulaParser;
+
+/**
+ * @brief Creates a parser for a periodic table.
+ *
+ * @param parser Double pointer to the parser that will be allocated.
+ * @param table Pointer to the periodic table, which must outlive the parser.
+ * @return int FORMULA_OK, or FORMULA_NO_MEMORY.
+ */
+FORMULA_API int initFormulaParser(FormulaParser **parser, PeriodicTable *table);
+
+/**
+ * @brief Frees a parser. The periodic table is not freed.
+ *
+ * @param parser Pointer to the parser.
+ */
+FORMULA_API void freeFormulaParser(FormulaParser *parser);
+
+/**
+ * @brief Reads a formula into the tokens of a parser.
+ *
+ * The stacks are made large enough for the formula first, so a failure of
+ * tokenizeFormula is always an error of the formula.
+ *
+ * @param parser Pointer to the parser.
+ * @param formula The formula, without a new line.
+ * @param length The length of the formula.
+ * @return int FORMULA_OK, FORMULA_INVALID, FORMULA_UNBALANCED or FORMULA_NO_MEMORY.
+ */
+FORMULA_API int readFormula(FormulaParser *parser, const char *formula, size_t length);
+
+/**
+ * @brief Counts the atoms of every element of a formula.
+ *
+ * @param parser Pointer to the parser.
+ * @param formula The formula, without a new line.
+ * @param length The length of the formula.
+ * @param counts Receives the count of every element, in the order of the table, table->size values.
+ * @return int FORMULA_OK, FORMULA_INVALID, FORMULA_UNBALANCED, FORMULA_NO_MEMORY,
+ * or FORMULA_TOO_LARGE when a count does not fit in 64 bits.
+ */
+FORMULA_API int parseCounts(FormulaParser *parser, const char *formula, size_t length, long long *counts);
+
+/**
+ * @brief Computes the total proton number of a formula.
+ *
+ * @param parser Pointer to the parser.
+ * @param formula The formula, without a new line.
+ * @param length The length of the formula.
+ * @param protons Pointer that receives the proton number.
+ * @return int FORMULA_OK, FORMULA_INVALID, FORMULA_UNBALANCED, FORMULA_NO_MEMORY or FORMULA_TOO_LARGE.
+ */
+FORMULA_API int parseProtonNumber(FormulaParser *parser, const char *formula, size_t length, long long *protons);
+
+/**
+ * @brief Computes the molar and monoisotopic masses of a formula.
+ *
+ * @param parser Pointer to the parser.
+ * @param formula The formula, without a new line.
+ * @param length The length of the formula.
+ * @param averageMass Pointer that receives the molar mass.
+ * @param exactMass Pointer that receives the monoisotopic mass.
+ * @return int FORMULA_OK, FORMULA_INVALID, FORMULA_UNBALANCED, FORMULA_NO_MEMORY,
+ * FORMULA_TOO_LARGE, or FORMULA_NO_MASSES when the table has no mass columns.
+ */
+FORMULA_API int parseMass(FormulaParser *parser, const char *formula, size_t length, double *averageMass, double *exactMass);
+
+/**
+ * @brief Writes the extended version of a formula as a null terminated string.
+ *
+ * @param parser Pointer to the parser.
+ * @param formula The formula, without a new line.
+ * @param length The length of the formula.
+ * @param buffer The buffer that receives the string.
+ * @param size The size of the buffer.
+ * @param needed Pointer that receives the size the string needs, or NULL.
+ * @return int FORMULA_OK, FORMULA_INVALID, FORMULA_UNBALANCED, FORMULA_NO_MEMORY,
+ * FORMULA_TOO_LARGE, or FORMULA_NO_SPACE when the buffer is smaller than needed.
+ */
+FORMULA_API int parseExpansion(FormulaParser *parser, const char *formula, size_t length, char *buffer, size_t size, size_t *needed);
+
+/**
+ * @brief Writes the Hill formula of a formula as a null terminated string.
+ *
+ * @param parser Pointer to the parser.
+ * @param formula The formula, without a new line.
+ * @param length The length of the formula.
+ * @param empirical Non zero to divide the counts by their greatest common divisor.
+ * @param buffer The buffer that receives the string.
+ * @param size The size of the buffer.
+ * @param needed Pointer that receives a size large enough for the string, or NULL.
+ * @return int FORMULA_OK, FORMULA_INVALID, FORMULA_UNBALANCED, FORMULA_NO_MEMORY,
+ * FORMULA_TOO_LARGE, or FORMULA_NO_SPACE when the buffer is too small.
+ */
+FORMULA_API int parseHillFormula(FormulaParser *parser, const char *formula, size_t length, int empirical, char *buffer, size_t size, size_t *needed);
+
+/**
+ * @brief Returns the description of a result of the library.
+ *
+ * @param code A FORMULA value.
+ * @return const char* The description.
+ */
+FORMULA_API const char *formulaError(int code);
+
+#endif
@@ -0,0 +1,19 @@
+/**
+ * @file Hash.c
+ *
+ * @brief FNV-1a hash of bytes.
+ *
+ * @author Nicolas Constantinou
+ * @date 23/10/2024
+ */
+#include "Hash.h"
+
+uint32_t hashBytes(const char *data, size_t length, uint32_t seed)
+{
+    uint32_t hash = seed;
+    for (size_t i = 0; i < length; i++)
+    {
+        hash = (hash ^ (unsigned char)data[i]) * 16777619u;
+    }
+    return hash;
+}
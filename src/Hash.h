@@ -0,0 +1,33 @@
+/**
+ * @file Hash.h
+ *
+ * @brief FNV-1a hash of bytes, shared by the cache, the bytecode and the checkpoints.
+ *
+ * @author Nicolas Constantinou
+ * @date 23/10/2024
+ */
+#ifndef Hash_h
+#define Hash_h
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @brief Hash of no bytes, the seed of a new hash.
+ */
+#define HASH_SEED 2166136261u
+
+/**
+ * @brief Computes the FNV-1a hash of bytes.
+ *
+ * A hash of several pieces is computed by passing the hash of the pieces
+ * before as the seed of the next one.
+ *
+ * @param data The bytes.
+ * @param length The number of bytes.
+ * @param seed HASH_SEED, or the hash of the bytes before.
+ * @return uint32_t The hash.
+ */
+uint32_t hashBytes(const char *data, size_t length, uint32_t seed);
+
+#endif
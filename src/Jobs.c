@@ -0,0 +1,421 @@
+/**
+ * @file Jobs.c
+ *
+ * @brief Runs a parsing mode over many input files with one loaded table.
+ *
+ * @author Nicolas Constantinou
+ * @date 23/10/2024
+ */
+#define _XOPEN_SOURCE 700
+#include <sys/stat.h>
+#include "Stack.h"
+#include "periodicTable.h"
+#include "Output.h"
+#include "LineReader.h"
+#include "Balance.h"
+#include "ParseFormula.h"
+#include "Batch.h"
+#include "Jobs.h"
+
+int runBatch(char *mode, char *pattern, char **files, int count, PeriodicTable *table, Options *options)
+{
+    /* the modes are in the order of their MODE_ numbers */
+    const char *modes[] = {"-ext", "-pn", "-counts", "-mass", "-bytecode"};
+    const char *results[] = {"extended version", "total proton number", "element counts",
+                             "molar and monoisotopic masses", "bytecode"};
+    JobQueue queue;
+    memset(&queue, 0, sizeof(JobQueue));
+    queue.table = table;
+    queue.mode = -1;
+    for (int i = 0; i <= MODE_BYTECODE; i++)
+    {
+        if (strcmp(mode, modes[i]) == 0)
+        {
+            queue.mode = i;
+        }
+    }
+    if (queue.mode < 0)
+    {
+        printf("The mode %s cannot run on a batch of files!\n", mode);
+        return EXIT_FAILURE;
+    }
+    if (queue.mode == MODE_MASS)
+    {
+        if (!hasMasses(table))
+        {
+            printf("The periodic table has no mass columns!\n");
+            return EXIT_FAILURE;
+        }
+    }
+
+    int status = EXIT_SUCCESS;
+    for (int i = 0; i < count && status == EXIT_SUCCESS; i++)
+    {
+        if (files[i][0] == '@')
+        {
+            status = addManifest(&queue, files[i] + 1, pattern);
+        }
+        else
+        {
+            status = addJob(&queue, files[i], strlen(files[i]), pattern);
+        }
+    }
+    if (status == EXIT_SUCCESS && queue.count == 0)
+    {
+        printf("The batch has no input files!\n");
+        status = EXIT_FAILURE;
+    }
+    if (status == EXIT_FAILURE || checkOutputs(&queue) == EXIT_FAILURE)
+    {
+        freeJobs(&queue);
+        return EXIT_FAILURE;
+    }
+
+    Stats *stats = options->stats;
+    if (stats != NULL)
+    {
+        startTimer(&stats->parse);
+    }
+    /* the threads are shared out between the files that run at the same time */
+    int pool = options->threads < queue.count ? options->threads : queue.count;
+    queue.options = *options;
+    queue.options.threads = options->threads / pool;
+    queue.options.cacheBytes = options->cacheBytes / pool;
+    qsort(queue.jobs, queue.count, sizeof(Job), compareJobSizes);
+    pthread_mutex_init(&queue.lock, NULL);
+
+    /* this thread takes files too, and a thread that does not start leaves its files to the others */
+    pthread_t *threads = pool > 1 ? (pthread_t *)statsCalloc(pool - 1, sizeof(pthread_t)) : NULL;
+    int started = 0;
+    while (threads != NULL && started < pool - 1 &&
+           pthread_create(&threads[started], NULL, runJobs, &queue) == 0)
+    {
+        started++;
+    }
+    runJobs(&queue);
+    for (int i = 0; i < started; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+    free(threads);
+    pthread_mutex_destroy(&queue.lock);
+
+    qsort(queue.jobs, queue.count, sizeof(Job), compareJobIndexes);
+    for (int i = 0; i < queue.count; i++)
+    {
+        Job *job = &queue.jobs[i];
+        if (stats != NULL)
+        {
+            stats->lines += job->stats.lines;
+            stats->bytesIn += job->stats.bytesIn;
+            stats->bytesOut += job->stats.bytesOut;
+            mergeStats(stats, &job->stats);
+        }
+        if (job->status == EXIT_FAILURE)
+        {
+            printf("Wrong input given from file %s!\n", job->input);
+            status = EXIT_FAILURE;
+        }
+    }
+    if (stats != NULL)
+    {
+        stopTimer(&stats->parse);
+    }
+
+    if (status == EXIT_SUCCESS && queue.mode == MODE_BYTECODE)
+    {
+        printf("Compile formulas in %d files to bytecode\n", queue.count);
+        printf("Writing bytecode to %s\n", pattern);
+    }
+    else if (status == EXIT_SUCCESS)
+    {
+        printf("Compute %s of formulas in %d files\n", results[queue.mode], queue.count);
+        printf("Writing formulas to %s\n", pattern);
+    }
+    freeJobs(&queue);
+    return status;
+}
+
+int addJob(JobQueue *queue, const char *input, size_t length, char *pattern)
+{
+    if (length == 1 && input[0] == '-')
+    {
+        printf("The standard input cannot be part of a batch!\n");
+        return EXIT_FAILURE;
+    }
+    if (queue->count == queue->capacity)
+    {
+        int capacity = queue->capacity > 0 ? queue->capacity * 2 : 16;
+        Job *jobs = (Job *)statsRealloc(queue->jobs, capacity * sizeof(Job));
+        if (jobs == NULL)
+        {
+            printf("Could not allocate the jobs!\n");
+            return EXIT_FAILURE;
+        }
+        queue->jobs = jobs;
+        queue->capacity = capacity;
+    }
+
+    Job *job = &queue->jobs[queue->count];
+    memset(job, 0, sizeof(Job));
+    job->input = (char *)statsMalloc(length + 1);
+    if (job->input == NULL)
+    {
+        printf("Could not allocate the jobs!\n");
+        return EXIT_FAILURE;
+    }
+    memcpy(job->input, input, length);
+    job->input[length] = '\0';
+    job->output = outputName(pattern, job->input);
+    if (job->output == NULL)
+    {
+        free(job->input);
+        return EXIT_FAILURE;
+    }
+    /* a file that cannot be read is reported when its turn comes */
+    struct stat info;
+    if (stat(job->input, &info) == 0)
+    {
+        job->size = (long long)info.st_size;
+        job->id.device = (unsigned long long)info.st_dev;
+        job->id.inode = (unsigned long long)info.st_ino;
+        job->found = 1;
+    }
+    job->index = queue->count;
+    queue->count++;
+    return EXIT_SUCCESS;
+}
+
+int addManifest(JobQueue *queue, char *manifest, char *pattern)
+{
+    LineReader *reader = NULL;
+    if (openReader(&reader, manifest) == EXIT_FAILURE)
+    {
+        return EXIT_FAILURE;
+    }
+    char *line = NULL;
+    size_t length = 0;
+    int status = EXIT_SUCCESS;
+    int more = 0;
+    while (status == EXIT_SUCCESS && (more = nextLine(reader, &line, &length)) == 1)
+    {
+        while (length > 0 && isspace((unsigned char)line[length - 1]))
+        {
+            length--;
+        }
+        while (length > 0 && isspace((unsigned char)line[0]))
+        {
+            line++;
+            length--;
+        }
+        if (length > 0 && line[0] != '#')
+        {
+            status = addJob(queue, line, length, pattern);
+        }
+    }
+    closeReader(reader);
+    return more < 0 ? EXIT_FAILURE : status;
+}
+
+char *outputName(char *pattern, char *input)
+{
+    /* the name of the input without its directory and its last extension */
+    char *base = strrchr(input, '/');
+    base = base == NULL ? input : base + 1;
+    char *dot = strrchr(base, '.');
+    size_t stem = dot == NULL || dot == base ? strlen(base) : (size_t)(dot - base);
+
+    char *mark = strstr(pattern, "%s");
+    size_t length = strlen(pattern) + (mark != NULL ? stem : 0);
+    char *name = (char *)statsMalloc(length + 1);
+    if (name == NULL)
+    {
+        printf("Could not allocate the jobs!\n");
+        return NULL;
+    }
+    if (mark == NULL)
+    {
+        memcpy(name, pattern, length + 1);
+        return name;
+    }
+    size_t prefix = (size_t)(mark - pattern);
+    memcpy(name, pattern, prefix);
+    memcpy(name + prefix, base, stem);
+    strcpy(name + prefix + stem, mark + 2);
+    return name;
+}
+
+int checkOutputs(JobQueue *queue)
+{
+    for (int i = 0; i < queue->count; i++)
+    {
+        queue->jobs[i].path = resolvePath(queue->jobs[i].output);
+        if (queue->jobs[i].path == NULL)
+        {
+            return EXIT_FAILURE;
+        }
+    }
+    /* with the outputs in order two inputs with the same output are next to each other */
+    qsort(queue->jobs, queue->count, sizeof(Job), compareJobOutputs);
+    for (int i = 1; i < queue->count; i++)
+    {
+        if (strcmp(queue->jobs[i - 1].path, queue->jobs[i].path) == 0)
+        {
+            printf("The files %s and %s would both be written to %s!\n",
+                   queue->jobs[i - 1].input, queue->jobs[i].input, queue->jobs[i].path);
+            return EXIT_FAILURE;
+        }
+    }
+
+    /* an output must not overwrite an input that is still to be read, under any of its names */
+    FileId *inputs = (FileId *)statsMalloc(queue->count * sizeof(FileId));
+    if (inputs == NULL)
+    {
+        printf("Could not allocate the jobs!\n");
+        return EXIT_FAILURE;
+    }
+    int found = 0;
+    for (int i = 0; i < queue->count; i++)
+    {
+        if (queue->jobs[i].found)
+        {
+            inputs[found++] = queue->jobs[i].id;
+        }
+    }
+    qsort(inputs, found, sizeof(FileId), compareFileIds);
+    int status = EXIT_SUCCESS;
+    for (int i = 0; i < queue->count && status == EXIT_SUCCESS; i++)
+    {
+        struct stat info;
+        if (stat(queue->jobs[i].output, &info) != 0)
+        {
+            continue;
+        }
+        FileId id;
+        id.device = (unsigned long long)info.st_dev;
+        id.inode = (unsigned long long)info.st_ino;
+        if (bsearch(&id, inputs, found, sizeof(FileId), compareFileIds) != NULL)
+        {
+            printf("The output %s of %s is an input of the batch!\n", queue->jobs[i].output, queue->jobs[i].input);
+            status = EXIT_FAILURE;
+        }
+    }
+    free(inputs);
+    return status;
+}
+
+char *resolvePath(char *fileName)
+{
+    char *path = realpath(fileName, NULL);
+    if (path != NULL)
+    {
+        return path;
+    }
+    /* a file that does not exist yet is resolved through its directory */
+    char *slash = strrchr(fileName, '/');
+    char *base = slash == NULL ? fileName : slash + 1;
+    char *directory = NULL;
+    if (slash == NULL)
+    {
+        directory = realpath(".", NULL);
+    }
+    else if (slash == fileName)
+    {
+        directory = realpath("/", NULL);
+    }
+    else
+    {
+        *slash = '\0';
+        directory = realpath(fileName, NULL);
+        *slash = '/';
+    }
+
+    size_t length = directory != NULL ? strlen(directory) + strlen(base) + 1 : strlen(fileName);
+    path = (char *)statsMalloc(length + 1);
+    if (path == NULL)
+    {
+        printf("Could not allocate the jobs!\n");
+    }
+    else if (directory == NULL)
+    {
+        strcpy(path, fileName);
+    }
+    else
+    {
+        sprintf(path, "%s/%s", strcmp(directory, "/") == 0 ? "" : directory, base);
+    }
+    free(directory);
+    return path;
+}
+
+void *runJobs(void *queue)
+{
+    JobQueue *jobs = (JobQueue *)queue;
+    while (1)
+    {
+        pthread_mutex_lock(&jobs->lock);
+        int next = jobs->next < jobs->count ? jobs->next++ : -1;
+        pthread_mutex_unlock(&jobs->lock);
+        if (next < 0)
+        {
+            return NULL;
+        }
+
+        /* every file counts its own statistics, they are added up at the end */
+        Job *job = &jobs->jobs[next];
+        Options options = jobs->options;
+        options.name = job->input;
+        options.stats = jobs->options.stats != NULL ? &job->stats : NULL;
+        job->status = processFile(job->input, job->output, jobs->table, &options, jobs->mode);
+    }
+}
+
+int compareJobSizes(const void *first, const void *second)
+{
+    const Job *a = (const Job *)first;
+    const Job *b = (const Job *)second;
+    if (a->size != b->size)
+    {
+        return a->size > b->size ? -1 : 1;
+    }
+    return a->index - b->index;
+}
+
+int compareJobIndexes(const void *first, const void *second)
+{
+    return ((const Job *)first)->index - ((const Job *)second)->index;
+}
+
+int compareJobOutputs(const void *first, const void *second)
+{
+    return strcmp(((const Job *)first)->path, ((const Job *)second)->path);
+}
+
+int compareFileIds(const void *first, const void *second)
+{
+    const FileId *a = (const FileId *)first;
+    const FileId *b = (const FileId *)second;
+    if (a->device != b->device)
+    {
+        return a->device < b->device ? -1 : 1;
+    }
+    if (a->inode != b->inode)
+    {
+        return a->inode < b->inode ? -1 : 1;
+    }
+    return 0;
+}
+
+void freeJobs(JobQueue *queue)
+{
+    for (int i = 0; i < queue->count; i++)
+    {
+        free(queue->jobs[i].input);
+        free(queue->jobs[i].output);
+        free(queue->jobs[i].path);
+    }
+    free(queue->jobs);
+    queue->jobs = NULL;
+    queue->count = 0;
+    queue->capacity = 0;
+}
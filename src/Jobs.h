@@ -0,0 +1,179 @@
+/**
+ * @file Jobs.h
+ *
+ * @brief Runs a parsing mode over many input files with one loaded table.
+ *
+ * The input files are given on the command line, or listed one per line in a
+ * manifest file named with a leading @. The output file of every input comes
+ * from a pattern, where %s stands for the name of the input without its
+ * directory and extension, e.g. out/%s.pn turns shards/a.txt into out/a.pn.
+ *
+ * The files are sorted largest first and handed out to a pool of threads,
+ * each taking the next file when it is done with one, so the threads finish
+ * at about the same time even when the sizes of the files differ a lot.
+ *
+ * @author Nicolas Constantinou
+ * @date 23/10/2024
+ */
+#ifndef Jobs_h
+#define Jobs_h
+
+#include <pthread.h>
+
+#include "Stats.h"
+
+/**
+ * @struct FileId
+ *
+ * @brief The device and inode of a file, the same for every name of the file.
+ */
+typedef struct fileId
+{
+    unsigned long long device;
+    unsigned long long inode;
+} FileId;
+
+/**
+ * @struct Job
+ *
+ * @brief One input file of a batch and the result of its run.
+ *
+ * path is the output with its directories resolved, id the identity of the
+ * input, which is only set when found is.
+ */
+typedef struct job
+{
+    char *input;
+    char *output;
+    char *path;
+    FileId id;
+    int found;
+    long long size;
+    int index;
+    int status;
+    Stats stats;
+} Job;
+
+/**
+ * @struct JobQueue
+ *
+ * @brief The files of a batch and the state shared by the threads of the pool.
+ *
+ * next is the first job not taken yet and is changed under lock. options are
+ * the options of every file, with the threads of one file.
+ */
+typedef struct jobQueue
+{
+    Job *jobs;
+    int count;
+    int capacity;
+    int next;
+    pthread_mutex_t lock;
+    PeriodicTable *table;
+    Options options;
+    int mode;
+} JobQueue;
+
+/**
+ * @brief Runs a mode over many input files.
+ *
+ * Every file is processed as by the mode on its own, and a failed file does not
+ * stop the others. The messages of a file start with its name.
+ *
+ * @param mode The mode: -ext, -pn, -counts, -mass or -bytecode.
+ * @param pattern The pattern of the output files.
+ * @param files The input files and manifests.
+ * @param count The number of files.
+ * @param table Pointer to the periodic table shared by all files.
+ * @param options Pointer to the command line options, -j gives the threads of the pool.
+ * @return int EXIT_SUCCESS if every file was processed, EXIT_FAILURE otherwise.
+ */
+int runBatch(char *mode, char *pattern, char **files, int count, PeriodicTable *table, Options *options);
+
+/**
+ * @brief Adds an input file to the queue, with its output file and size.
+ *
+ * @param queue Pointer to the queue.
+ * @param input Name of the input file.
+ * @param length Length of the name.
+ * @param pattern The pattern of the output files.
+ * @return int EXIT_SUCCESS on success, EXIT_FAILURE on error.
+ */
+int addJob(JobQueue *queue, const char *input, size_t length, char *pattern);
+
+/**
+ * @brief Adds every file listed in a manifest to the queue.
+ *
+ * Empty lines and lines starting with # are skipped.
+ *
+ * @param queue Pointer to the queue.
+ * @param manifest Name of the manifest file.
+ * @param pattern The pattern of the output files.
+ * @return int EXIT_SUCCESS on success, EXIT_FAILURE on error.
+ */
+int addManifest(JobQueue *queue, char *manifest, char *pattern);
+
+/**
+ * @brief Makes the name of the output file of an input file.
+ *
+ * @param pattern The pattern of the output files.
+ * @param input Name of the input file.
+ * @return char* The allocated name, or NULL on error.
+ */
+char *outputName(char *pattern, char *input);
+
+/**
+ * @brief Checks that no two input files get the same output file and no output is an input.
+ *
+ * The files are compared by their resolved paths and their identities, so other
+ * names of the same file, such as ./a.txt for a.txt or a link, are caught too.
+ *
+ * @param queue Pointer to the queue, sorted by output path on return.
+ * @return int EXIT_SUCCESS on success, EXIT_FAILURE if an output is not usable.
+ */
+int checkOutputs(JobQueue *queue);
+
+/**
+ * @brief Processes the files of the queue until none is left.
+ *
+ * @param queue Pointer to the queue, passed as void* to be a thread function.
+ * @return void* Always NULL.
+ */
+void *runJobs(void *queue);
+
+/**
+ * @brief Orders jobs largest file first, then in the order they were given.
+ */
+int compareJobSizes(const void *first, const void *second);
+
+/**
+ * @brief Orders jobs in the order they were given.
+ */
+int compareJobIndexes(const void *first, const void *second);
+
+/**
+ * @brief Resolves the directories and links of the name of a file that may not exist yet.
+ *
+ * @param fileName Name of the file.
+ * @return char* The allocated path, the name itself when its directory does not exist, or NULL on error.
+ */
+char *resolvePath(char *fileName);
+
+/**
+ * @brief Orders jobs by the resolved path of their output file.
+ */
+int compareJobOutputs(const void *first, const void *second);
+
+/**
+ * @brief Orders file identities.
+ */
+int compareFileIds(const void *first, const void *second);
+
+/**
+ * @brief Frees the jobs of a queue.
+ *
+ * @param queue Pointer to the queue.
+ */
+void freeJobs(JobQueue *queue);
+
+#endif
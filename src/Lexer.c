@@ -0,0 +1,85 @@
+/**
+ * @file Lexer.c
+ *
+ * @brief Vectorized classification of the characters of formulas.
+ *
+ * @author Nicolas Constantinou
+ * @date 23/10/2024
+ */
+#include "Lexer.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+
+/**
+ * @brief Mask of the bytes of v from first to first + count - 1.
+ *
+ * Adding 128 - first moves the range to the bottom of the signed bytes,
+ * so one signed compare tests both of its ends.
+ */
+#define RANGE_MASK(v, first, count) \
+    ((uint64_t)(unsigned int)_mm_movemask_epi8(_mm_cmplt_epi8(_mm_add_epi8((v), _mm_set1_epi8((char)(128 - (first)))), _mm_set1_epi8((char)(-128 + (count))))))
+#endif
+
+void classifyFormula(const char *data, LexMasks *masks)
+{
+    memset(masks, 0, sizeof(LexMasks));
+#ifdef __SSE2__
+    const __m128i open = _mm_set1_epi8('(');
+    const __m128i close = _mm_set1_epi8(')');
+    for (int i = 0; i < LEXER_WINDOW; i += 16)
+    {
+        __m128i bytes = _mm_loadu_si128((const __m128i *)(data + i));
+        masks->upper |= RANGE_MASK(bytes, 'A', 26) << i;
+        masks->lower |= RANGE_MASK(bytes, 'a', 26) << i;
+        masks->digit |= RANGE_MASK(bytes, '0', 10) << i;
+        masks->open |= (uint64_t)(unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, open)) << i;
+        masks->close |= (uint64_t)(unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, close)) << i;
+    }
+#else
+    for (int i = 0; i < LEXER_WINDOW; i++)
+    {
+        unsigned char c = (unsigned char)data[i];
+        masks->upper |= (uint64_t)(c - 'A' < 26u) << i;
+        masks->lower |= (uint64_t)(c - 'a' < 26u) << i;
+        masks->digit |= (uint64_t)(c - '0' < 10u) << i;
+        masks->open |= (uint64_t)(c == '(') << i;
+        masks->close |= (uint64_t)(c == ')') << i;
+    }
+#endif
+}
+
+void classifyAt(const char *buffer, size_t length, size_t start, LexMasks *masks)
+{
+    if (length - start >= LEXER_WINDOW)
+    {
+        classifyFormula(buffer + start, masks);
+        return;
+    }
+    /* zero bytes belong to no class */
+    char window[LEXER_WINDOW];
+    memset(window, 0, LEXER_WINDOW);
+    memcpy(window, buffer + start, length - start);
+    classifyFormula(window, masks);
+}
+
+int lowestBit(uint64_t mask)
+{
+#ifdef __GNUC__
+    return __builtin_ctzll(mask);
+#else
+    int bit = 0;
+    while (!(mask & 1))
+    {
+        mask >>= 1;
+        bit++;
+    }
+    return bit;
+#endif
+}
+
+int countRun(uint64_t mask, int bit)
+{
+    uint64_t clear = ~(mask >> bit);
+    return clear == 0 ? LEXER_WINDOW - bit : lowestBit(clear);
+}
@@ -0,0 +1,80 @@
+/**
+ * @file Lexer.h
+ *
+ * @brief Character classes of formulas as bit masks.
+ *
+ * A formula is classified 64 bytes at a time into masks of uppercase and
+ * lowercase letters, digits and parentheses, with SSE2 range compares when
+ * they are available. The parsers then visit only the set bits, in order,
+ * and read the length of a symbol or a number from the masks instead of
+ * testing every character.
+ *
+ * @author Nicolas Constantinou
+ * @date 23/10/2024
+ */
+#ifndef Lexer_h
+#define Lexer_h
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdint.h>
+
+/**
+ * @brief Number of bytes classified together.
+ */
+#define LEXER_WINDOW 64
+
+/**
+ * @struct LexMasks
+ *
+ * @brief Masks of the character classes of a window, bit i for byte i.
+ */
+typedef struct lexMasks
+{
+    uint64_t upper;
+    uint64_t lower;
+    uint64_t digit;
+    uint64_t open;
+    uint64_t close;
+} LexMasks;
+
+/**
+ * @brief Classifies a window of LEXER_WINDOW bytes.
+ *
+ * @param data The window.
+ * @param masks Pointer that receives the masks.
+ */
+void classifyFormula(const char *data, LexMasks *masks);
+
+/**
+ * @brief Classifies the window of a formula that starts at an offset.
+ *
+ * A window that would pass the end of the formula is copied to a buffer
+ * padded with zeros first, so nothing after the formula is read.
+ *
+ * @param buffer The formula string.
+ * @param length The length of the formula.
+ * @param start The offset of the window.
+ * @param masks Pointer that receives the masks.
+ */
+void classifyAt(const char *buffer, size_t length, size_t start, LexMasks *masks);
+
+/**
+ * @brief Counts the bits set in a mask from a bit up, before the first clear one.
+ *
+ * @param mask The mask.
+ * @param bit The first bit, from 0 to 63.
+ * @return int The number of consecutive set bits.
+ */
+int countRun(uint64_t mask, int bit);
+
+/**
+ * @brief Position of the lowest set bit of a non zero mask.
+ *
+ * @param mask The mask.
+ * @return int The position from 0 to 63.
+ */
+int lowestBit(uint64_t mask);
+
+#endif
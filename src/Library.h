@@ -0,0 +1,30 @@
+/**
+ * @file Library.h
+ *
+ * @brief Macros of the sources that are also built into the library.
+ *
+ * The library is compiled with PARSE_FORMULA_LIBRARY and -fvisibility=hidden,
+ * so libformula.so exports only the functions marked FORMULA_API. Its errors
+ * are told by the return values alone, so printError prints nothing there.
+ *
+ * @author Nicolas Constantinou
+ * @date 23/10/2024
+ */
+#ifndef Library_h
+#define Library_h
+
+#include <stdio.h>
+
+#ifdef __GNUC__
+#define FORMULA_API __attribute__((visibility("default")))
+#else
+#define FORMULA_API
+#endif
+
+#ifdef PARSE_FORMULA_LIBRARY
+#define printError(...) ((void)0)
+#else
+#define printError(...) printf(__VA_ARGS__)
+#endif
+
+#endif
@@ -0,0 +1,271 @@
+/**
+ * @file LineReader.c
+ *
+ * @brief Reading of text files as lines without copying them.
+ *
+ * @author Nicolas Constantinou
+ * @date 23/10/2024
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "LineReader.h"
+#include "Stats.h"
+
+int openReader(LineReader **reader, char *fileName)
+{
+    int fd = STDIN_FILENO;
+    if (strcmp(fileName, STANDARD_INPUT) != 0)
+    {
+        fd = open(fileName, O_RDONLY);
+    }
+    if (fd < 0)
+    {
+        printError("Could not open %s!\n", fileName);
+        return EXIT_FAILURE;
+    }
+
+    (*reader) = (LineReader *)statsCalloc(1, sizeof(LineReader));
+    if ((*reader) == NULL)
+    {
+        printError("Could not allocate the reader!\n");
+        close(fd);
+        return EXIT_FAILURE;
+    }
+    (*reader)->fd = fd;
+
+    struct stat info;
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode))
+    {
+        if (info.st_size == 0)
+        {
+            (*reader)->eof = 1;
+            return EXIT_SUCCESS;
+        }
+        void *map = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map != MAP_FAILED)
+        {
+            posix_madvise(map, info.st_size, POSIX_MADV_SEQUENTIAL);
+            (*reader)->data = (char *)map;
+            (*reader)->mapSize = info.st_size;
+            (*reader)->end = info.st_size;
+            (*reader)->eof = 1;
+            return EXIT_SUCCESS;
+        }
+    }
+
+    /* pipes and files that cannot be mapped are read in a window */
+    (*reader)->capacity = READER_WINDOW_SIZE;
+    (*reader)->window = (char *)statsMalloc((*reader)->capacity);
+    if ((*reader)->window == NULL)
+    {
+        printError("Could not allocate the read buffer!\n");
+        closeReader(*reader);
+        return EXIT_FAILURE;
+    }
+    (*reader)->data = (*reader)->window;
+    return EXIT_SUCCESS;
+}
+
+int fillReader(LineReader *reader)
+{
+    if (reader->eof)
+    {
+        return 0;
+    }
+    if (reader->start > 0)
+    {
+        memmove(reader->window, reader->window + reader->start, reader->end - reader->start);
+        reader->end -= reader->start;
+        reader->start = 0;
+    }
+    if (reader->end == reader->capacity)
+    {
+        char *window = (char *)statsRealloc(reader->window, reader->capacity * 2);
+        if (window == NULL)
+        {
+            printError("Could not grow the read buffer!\n");
+            return -1;
+        }
+        reader->window = window;
+        reader->data = window;
+        reader->capacity *= 2;
+    }
+
+    ssize_t n;
+    do
+    {
+        n = read(reader->fd, reader->window + reader->end, reader->capacity - reader->end);
+    } while (n < 0 && errno == EINTR);
+    if (n < 0)
+    {
+        printError("Could not read the input!\n");
+        return -1;
+    }
+    if (n == 0)
+    {
+        reader->eof = 1;
+        return 0;
+    }
+    reader->partial = (size_t)n < reader->capacity - reader->end;
+    reader->end += n;
+    return 1;
+}
+
+int skipBytes(LineReader *reader, size_t size)
+{
+    while (reader->end - reader->start < size)
+    {
+        size -= reader->end - reader->start;
+        reader->start = reader->end;
+        int filled = fillReader(reader);
+        if (filled <= 0)
+        {
+            return filled;
+        }
+    }
+    reader->start += size;
+    return 1;
+}
+
+int nextLine(LineReader *reader, char **line, size_t *length)
+{
+    size_t searched = reader->start;
+    while (1)
+    {
+        char *newLine = (char *)memchr(reader->data + searched, '\n', reader->end - searched);
+        if (newLine != NULL)
+        {
+            *line = reader->data + reader->start;
+            *length = newLine - *line;
+            reader->start = newLine - reader->data + 1;
+            return 1;
+        }
+        searched = reader->end;
+
+        size_t start = reader->start;
+        int filled = fillReader(reader);
+        if (filled < 0)
+        {
+            return -1;
+        }
+        searched -= start - reader->start;
+        if (filled == 0)
+        {
+            break;
+        }
+    }
+
+    if (reader->start == reader->end)
+    {
+        return 0;
+    }
+    /* the last line of the file has no new line */
+    *line = reader->data + reader->start;
+    *length = reader->end - reader->start;
+    reader->start = reader->end;
+    return 1;
+}
+
+int nextBlock(LineReader *reader, size_t size, char **block, size_t *length)
+{
+    while (reader->end - reader->start < size && !reader->eof)
+    {
+        if (reader->window != NULL && reader->capacity < size)
+        {
+            /* let the window hold a whole block */
+            char *window = (char *)statsRealloc(reader->window, size);
+            if (window == NULL)
+            {
+                printError("Could not grow the read buffer!\n");
+                return -1;
+            }
+            reader->window = window;
+            reader->data = window;
+            reader->capacity = size;
+        }
+        if (fillReader(reader) < 0)
+        {
+            return -1;
+        }
+        /* a stream that has nothing more for now hands out its complete lines */
+        if (reader->partial && memchr(reader->data + reader->start, '\n', reader->end - reader->start) != NULL)
+        {
+            break;
+        }
+    }
+
+    size_t available = reader->end - reader->start;
+    if (available == 0)
+    {
+        return 0;
+    }
+
+    size_t stop = reader->start + (available < size ? available : size);
+    if (stop < reader->end || !reader->eof)
+    {
+        /* cut after the last new line of the block, or after the first one when a line is longer */
+        size_t cut = stop;
+        while (cut > reader->start && reader->data[cut - 1] != '\n')
+        {
+            cut--;
+        }
+        if (cut == reader->start)
+        {
+            char *newLine = NULL;
+            while ((newLine = (char *)memchr(reader->data + stop, '\n', reader->end - stop)) == NULL)
+            {
+                size_t start = reader->start;
+                stop = reader->end;
+                int filled = fillReader(reader);
+                if (filled < 0)
+                {
+                    return -1;
+                }
+                stop -= start - reader->start;
+                if (filled == 0)
+                {
+                    break;
+                }
+            }
+            cut = newLine == NULL ? reader->end : (size_t)(newLine - reader->data) + 1;
+        }
+        stop = cut;
+    }
+
+    *block = reader->data + reader->start;
+    *length = stop - reader->start;
+    reader->start = stop;
+    return 1;
+}
+
+int peekBytes(LineReader *reader, size_t size, char **data)
+{
+    while (reader->end - reader->start < size)
+    {
+        int filled = fillReader(reader);
+        if (filled <= 0)
+        {
+            return filled;
+        }
+    }
+    *data = reader->data + reader->start;
+    return 1;
+}
+
+void closeReader(LineReader *reader)
+{
+    if (reader->window == NULL && reader->mapSize > 0)
+    {
+        munmap(reader->data, reader->mapSize);
+    }
+    free(reader->window);
+    if (reader->fd != STDIN_FILENO)
+    {
+        close(reader->fd);
+    }
+    free(reader);
+}
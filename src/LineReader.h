@@ -0,0 +1,138 @@
+/**
+ * @file LineReader.h
+ *
+ * @brief Reading of text files as lines without copying them.
+ *
+ * A regular file is mapped in memory and its lines are returned as pointers
+ * into the mapping. Files that cannot be mapped are read with read() into a
+ * window that grows to hold the longest line. Lines have no length limit
+ * and are not null terminated.
+ *
+ * @author Nicolas Constantinou
+ * @date 23/10/2024
+ */
+#ifndef LineReader_h
+#define LineReader_h
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "Library.h"
+
+/**
+ * @brief Initial size of the read() window in bytes.
+ */
+#define READER_WINDOW_SIZE (1 << 16)
+
+/**
+ * @brief File name that selects the standard input.
+ */
+#define STANDARD_INPUT "-"
+
+/**
+ * @struct LineReader
+ *
+ * @brief Structure of an open input file and the part of it not read yet.
+ *
+ * data points to the mapping or to the read() window, the unread bytes are
+ * data[start] up to data[end - 1]. window is NULL when the file is mapped.
+ * partial is set when the last read() returned less than it asked for.
+ */
+typedef struct lineReader
+{
+    int fd;
+    char *data;
+    char *window;
+    size_t mapSize;
+    size_t capacity;
+    size_t start;
+    size_t end;
+    int eof;
+    int partial;
+} LineReader;
+
+/**
+ * @brief Opens a file for reading lines.
+ *
+ * The name "-" reads the standard input, which is never closed by the reader.
+ *
+ * @param reader Double pointer to the reader that will be allocated.
+ * @param fileName Name of the file.
+ * @return int Returns EXIT_SUCCESS on success or EXIT_FAILURE on failure.
+ */
+int openReader(LineReader **reader, char *fileName);
+
+/**
+ * @brief Reads more of the file into the window.
+ *
+ * The unread bytes are moved to the front of the window, which doubles when
+ * it is already full of unread bytes. A mapped file has nothing more to read.
+ *
+ * @param reader Pointer of reader.
+ * @return int 1 if bytes were added, 0 at the end of the file, -1 on error.
+ */
+int fillReader(LineReader *reader);
+
+/**
+ * @brief Skips bytes of the file without returning them.
+ *
+ * A mapped file skips them at once, other files read through them.
+ *
+ * @param reader Pointer of reader.
+ * @param size The number of bytes to skip.
+ * @return int 1 if the bytes were skipped, 0 if the file ends before them, -1 on error.
+ */
+int skipBytes(LineReader *reader, size_t size);
+
+/**
+ * @brief Returns the next line of the file.
+ *
+ * The line does not include its new line character. It stays valid until the
+ * next call on the reader, or until the reader is closed for a mapped file.
+ *
+ * @param reader Pointer of reader.
+ * @param line Pointer to store the first character of the line.
+ * @param length Pointer to store the length of the line.
+ * @return int 1 if a line was returned, 0 at the end of the file, -1 on error.
+ */
+int nextLine(LineReader *reader, char **line, size_t *length);
+
+/**
+ * @brief Returns the next block of complete lines of the file.
+ *
+ * The block holds about size bytes, the lines with their new line characters,
+ * except possibly the last line of the file. A block is larger than size only
+ * when a single line is. A pipe that has no more data for now returns the
+ * complete lines it has, so a stream is processed as it arrives. The block
+ * stays valid like a line of nextLine.
+ *
+ * @param reader Pointer of reader.
+ * @param size The wanted size of the block.
+ * @param block Pointer to store the first character of the block.
+ * @param length Pointer to store the length of the block.
+ * @return int 1 if a block was returned, 0 at the end of the file, -1 on error.
+ */
+int nextBlock(LineReader *reader, size_t size, char **block, size_t *length);
+
+/**
+ * @brief Makes the next size bytes of the file readable without consuming them.
+ *
+ * The bytes stay valid like a line of nextLine. The reader moves past them
+ * only by changing start.
+ *
+ * @param reader Pointer of reader.
+ * @param size The number of bytes.
+ * @param data Pointer to store the first of the bytes.
+ * @return int 1 if the bytes were read, 0 if the file ends before, -1 on error.
+ */
+int peekBytes(LineReader *reader, size_t size, char **data);
+
+/**
+ * @brief Closes the file and frees the reader from the memory.
+ *
+ * @param reader Pointer of reader.
+ */
+void closeReader(LineReader *reader);
+
+#endif
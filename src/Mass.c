@@ -0,0 +1,66 @@
+/**
+ * @file Mass.c
+ *
+ * @brief Vectorized kernel for the masses of formulas.
+ *
+ * @author Nicolas Constantinou
+ * @date 23/10/2024
+ */
+#include "Mass.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+void computeMasses(const long long *counts, int rows, int width, const double *masses, double *results)
+{
+    const double *average = masses;
+    const double *exact = masses + width;
+
+    for (int row = 0; row < rows; row++)
+    {
+        const long long *count = counts + (size_t)row * width;
+        double averageLanes[2] = {0.0, 0.0};
+        double exactLanes[2] = {0.0, 0.0};
+        int i = 0;
+
+#ifdef __SSE2__
+        __m128d averageSums = _mm_setzero_pd();
+        __m128d exactSums = _mm_setzero_pd();
+        for (; i + 4 <= width; i += 4)
+        {
+            /* SSE2 has no conversion of 64 bit integers, the four counts are converted one by one */
+            __m128d low = _mm_set_pd((double)count[i + 1], (double)count[i]);
+            __m128d high = _mm_set_pd((double)count[i + 3], (double)count[i + 2]);
+            averageSums = _mm_add_pd(averageSums, _mm_mul_pd(low, _mm_loadu_pd(average + i)));
+            averageSums = _mm_add_pd(averageSums, _mm_mul_pd(high, _mm_loadu_pd(average + i + 2)));
+            exactSums = _mm_add_pd(exactSums, _mm_mul_pd(low, _mm_loadu_pd(exact + i)));
+            exactSums = _mm_add_pd(exactSums, _mm_mul_pd(high, _mm_loadu_pd(exact + i + 2)));
+        }
+        _mm_storeu_pd(averageLanes, averageSums);
+        _mm_storeu_pd(exactLanes, exactSums);
+#else
+        /* the same two lanes as with SSE2, so both builds round the same way */
+        for (; i + 4 <= width; i += 4)
+        {
+            for (int lane = 0; lane < 2; lane++)
+            {
+                averageLanes[lane] += (double)count[i + lane] * average[i + lane];
+                averageLanes[lane] += (double)count[i + lane + 2] * average[i + lane + 2];
+                exactLanes[lane] += (double)count[i + lane] * exact[i + lane];
+                exactLanes[lane] += (double)count[i + lane + 2] * exact[i + lane + 2];
+            }
+        }
+#endif
+
+        double averageSum = averageLanes[0] + averageLanes[1];
+        double exactSum = exactLanes[0] + exactLanes[1];
+        for (; i < width; i++)
+        {
+            averageSum += (double)count[i] * average[i];
+            exactSum += (double)count[i] * exact[i];
+        }
+        results[2 * row] = averageSum;
+        results[2 * row + 1] = exactSum;
+    }
+}
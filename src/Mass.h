@@ -0,0 +1,37 @@
+/**
+ * @file Mass.h
+ *
+ * @brief Formula masses as dot products of element counts and mass vectors.
+ *
+ * The counts of a batch of formulas are kept as the rows of a matrix, and
+ * every row is multiplied with the average and the exact mass vector of the
+ * periodic table in one pass. With SSE2 two elements are converted and
+ * multiplied at a time, otherwise a plain loop computes the same sums.
+ *
+ * @author Nicolas Constantinou
+ * @date 23/10/2024
+ */
+#ifndef Mass_h
+#define Mass_h
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+/**
+ * @brief Number of formulas whose masses are computed together.
+ */
+#define MASS_BATCH 64
+
+/**
+ * @brief Computes the average and exact masses of a batch of formulas.
+ *
+ * @param counts Matrix of rows element count arrays of width counts each.
+ * @param rows Number of formulas in the batch.
+ * @param width Number of elements of the periodic table.
+ * @param masses The average mass vector followed by the exact mass vector, width each.
+ * @param results Receives the average and the exact mass of every formula, 2 * rows values.
+ */
+void computeMasses(const long long *counts, int rows, int width, const double *masses, double *results);
+
+#endif
@@ -0,0 +1,320 @@
+/**
+ * @file Output.c
+ *
+ * @brief Buffered output file operations.
+ *
+ * @author Nicolas Constantinou
+ * @date 23/10/2024
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <unistd.h>
+#include <sys/stat.h>
+#include "Output.h"
+
+int openOutput(Output **out, char *fileName, int atomic)
+{
+    (*out) = (Output *)statsCalloc(1, sizeof(Output));
+    if ((*out) == NULL)
+    {
+        printf("Could not allocate the output!\n");
+        return EXIT_FAILURE;
+    }
+    (*out)->atomic = atomic;
+    (*out)->capacity = OUTPUT_BUFFER_SIZE;
+    (*out)->name = (char *)statsMalloc(strlen(fileName) + 1);
+    (*out)->writeName = (char *)statsMalloc(strlen(fileName) + 5);
+    (*out)->buffer = (char *)statsMalloc((*out)->capacity);
+    if ((*out)->name == NULL || (*out)->writeName == NULL || (*out)->buffer == NULL)
+    {
+        printf("Could not allocate the output buffer!\n");
+        closeOutput(*out, EXIT_FAILURE);
+        (*out) = NULL;
+        return EXIT_FAILURE;
+    }
+    strcpy((*out)->name, fileName);
+    strcpy((*out)->writeName, fileName);
+
+    if (strcmp(fileName, STANDARD_STREAM) == 0)
+    {
+        /* results keep the real standard output, messages of printf go to the standard error */
+        (*out)->stream = 1;
+        (*out)->hold = atomic;
+        fflush(stdout);
+        int fd = dup(STDOUT_FILENO);
+        if (fd >= 0 && dup2(STDERR_FILENO, STDOUT_FILENO) >= 0)
+        {
+            (*out)->fp = fdopen(fd, "w");
+        }
+        if ((*out)->fp == NULL)
+        {
+            printf("Could not open the standard output!\n");
+            closeOutput(*out, EXIT_FAILURE);
+            (*out) = NULL;
+            return EXIT_FAILURE;
+        }
+        setvbuf((*out)->fp, NULL, _IONBF, 0);
+        return EXIT_SUCCESS;
+    }
+
+    if (atomic)
+    {
+        strcat((*out)->writeName, ".tmp");
+    }
+    (*out)->fp = fopen((*out)->writeName, "w");
+    if ((*out)->fp == NULL)
+    {
+        printf("Could not open %s!\n", (*out)->writeName);
+        closeOutput(*out, EXIT_FAILURE);
+        (*out) = NULL;
+        return EXIT_FAILURE;
+    }
+    /* the output buffer already batches the writes */
+    setvbuf((*out)->fp, NULL, _IONBF, 0);
+    return EXIT_SUCCESS;
+}
+
+int openAppendOutput(Output **out, char *fileName, size_t length)
+{
+    if (length == 0)
+    {
+        return openOutput(out, fileName, 0);
+    }
+    struct stat info;
+    if (stat(fileName, &info) != 0 || !S_ISREG(info.st_mode) || (size_t)info.st_size < length)
+    {
+        printf("The output %s is shorter than its checkpoint!\n", fileName);
+        return EXIT_FAILURE;
+    }
+    if (truncate(fileName, (off_t)length) != 0)
+    {
+        printf("Could not cut %s back to its checkpoint!\n", fileName);
+        return EXIT_FAILURE;
+    }
+
+    if (openBufferOutput(out) == EXIT_FAILURE)
+    {
+        return EXIT_FAILURE;
+    }
+    (*out)->name = (char *)statsMalloc(strlen(fileName) + 1);
+    (*out)->writeName = (char *)statsMalloc(strlen(fileName) + 1);
+    if ((*out)->name == NULL || (*out)->writeName == NULL)
+    {
+        printf("Could not allocate the output buffer!\n");
+        closeOutput(*out, EXIT_FAILURE);
+        (*out) = NULL;
+        return EXIT_FAILURE;
+    }
+    strcpy((*out)->name, fileName);
+    strcpy((*out)->writeName, fileName);
+    (*out)->fp = fopen(fileName, "a");
+    if ((*out)->fp == NULL)
+    {
+        printf("Could not open %s!\n", fileName);
+        closeOutput(*out, EXIT_FAILURE);
+        (*out) = NULL;
+        return EXIT_FAILURE;
+    }
+    setvbuf((*out)->fp, NULL, _IONBF, 0);
+    (*out)->written = length;
+    return EXIT_SUCCESS;
+}
+
+int openBufferOutput(Output **out)
+{
+    (*out) = (Output *)statsCalloc(1, sizeof(Output));
+    if ((*out) == NULL)
+    {
+        printf("Could not allocate the output!\n");
+        return EXIT_FAILURE;
+    }
+    (*out)->capacity = OUTPUT_BUFFER_SIZE;
+    (*out)->buffer = (char *)statsMalloc((*out)->capacity);
+    if ((*out)->buffer == NULL)
+    {
+        printf("Could not allocate the output buffer!\n");
+        free(*out);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+void initFixedOutput(Output *out, char *buffer, size_t capacity)
+{
+    memset(out, 0, sizeof(Output));
+    out->buffer = buffer;
+    out->capacity = capacity;
+    out->fixed = 1;
+}
+
+int flushOutput(Output *out)
+{
+    if (out->fp == NULL || out->hold)
+    {
+        return EXIT_SUCCESS;
+    }
+    if (out->size > 0 && writeFile(out, out->buffer, out->size) == EXIT_FAILURE)
+    {
+        return EXIT_FAILURE;
+    }
+    out->size = 0;
+    return EXIT_SUCCESS;
+}
+
+int syncOutput(Output *out)
+{
+    if (flushOutput(out) == EXIT_FAILURE)
+    {
+        return EXIT_FAILURE;
+    }
+    if (out->stats != NULL)
+    {
+        startTimer(&out->stats->write);
+    }
+    int status = fflush(out->fp) == 0 && fsync(fileno(out->fp)) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    if (out->stats != NULL)
+    {
+        stopTimer(&out->stats->write);
+    }
+    if (status == EXIT_FAILURE)
+    {
+        printf("Could not write to %s!\n", out->writeName);
+    }
+    return status;
+}
+
+int writeFile(Output *out, const char *data, size_t length)
+{
+    if (out->stats != NULL)
+    {
+        startTimer(&out->stats->write);
+    }
+    size_t count = fwrite(data, 1, length, out->fp);
+    if (out->stats != NULL)
+    {
+        stopTimer(&out->stats->write);
+        out->stats->bytesOut += count;
+    }
+    if (count != length)
+    {
+        printf("Could not write to %s!\n", out->writeName);
+        return EXIT_FAILURE;
+    }
+    out->written += length;
+    return EXIT_SUCCESS;
+}
+
+int writeOutput(Output *out, const char *data, size_t length)
+{
+    if (out->size + length > out->capacity && out->fixed)
+    {
+        return EXIT_FAILURE;
+    }
+    if (out->size + length > out->capacity && (out->fp == NULL || out->hold))
+    {
+        size_t capacity = out->capacity;
+        while (capacity < out->size + length)
+        {
+            capacity *= 2;
+        }
+        char *buffer = (char *)statsRealloc(out->buffer, capacity);
+        if (buffer == NULL)
+        {
+            printf("Could not grow the output buffer!\n");
+            return EXIT_FAILURE;
+        }
+        out->buffer = buffer;
+        out->capacity = capacity;
+    }
+    else if (out->size + length > out->capacity)
+    {
+        if (flushOutput(out) == EXIT_FAILURE)
+        {
+            return EXIT_FAILURE;
+        }
+        if (length > out->capacity)
+        {
+            return writeFile(out, data, length);
+        }
+    }
+    memcpy(out->buffer + out->size, data, length);
+    out->size += length;
+    return EXIT_SUCCESS;
+}
+
+int writeString(Output *out, const char *data)
+{
+    return writeOutput(out, data, strlen(data));
+}
+
+int writeNumber(Output *out, long long number)
+{
+    if (writeInteger(out, number) == EXIT_FAILURE)
+    {
+        return EXIT_FAILURE;
+    }
+    return writeOutput(out, "\n", 1);
+}
+
+int writeInteger(Output *out, long long number)
+{
+    char digits[24];
+    int i = sizeof(digits);
+    unsigned long long value = number < 0 ? 0ULL - (unsigned long long)number : (unsigned long long)number;
+
+    do
+    {
+        digits[--i] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value > 0);
+    if (number < 0)
+    {
+        digits[--i] = '-';
+    }
+    return writeOutput(out, digits + i, sizeof(digits) - i);
+}
+
+int closeOutput(Output *out, int status)
+{
+    if (out->fp != NULL)
+    {
+        /* without the atomic option the results before a failure are kept */
+        if ((status == EXIT_SUCCESS || !out->atomic) && flushOutput(out) == EXIT_FAILURE)
+        {
+            status = EXIT_FAILURE;
+        }
+        if (status == EXIT_SUCCESS && out->hold)
+        {
+            out->hold = 0;
+            status = flushOutput(out);
+        }
+        if (out->stats != NULL)
+        {
+            startTimer(&out->stats->write);
+        }
+        if (fclose(out->fp) != 0)
+        {
+            status = EXIT_FAILURE;
+        }
+        if (out->atomic && !out->stream)
+        {
+            if (status == EXIT_SUCCESS && rename(out->writeName, out->name) != 0)
+            {
+                printf("Could not write %s!\n", out->name);
+                status = EXIT_FAILURE;
+            }
+            if (status == EXIT_FAILURE)
+            {
+                remove(out->writeName);
+            }
+        }
+        if (out->stats != NULL)
+        {
+            stopTimer(&out->stats->write);
+        }
+    }
+    free(out->name);
+    free(out->writeName);
+    free(out->buffer);
+    free(out);
+    return status;
+}
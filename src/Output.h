@@ -0,0 +1,195 @@
+/**
+ * @file Output.h
+ *
+ * @brief Buffered output file shared by the parsing modes.
+ *
+ * An Output keeps one file open for the whole run and collects the results
+ * in a large buffer, which is written to the file in big blocks. An Output
+ * without a file only collects the results in its growing buffer.
+ *
+ * @author Nicolas Constantinou
+ * @date 23/10/2024
+ */
+#ifndef Output_h
+#define Output_h
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "Stats.h"
+
+/**
+ * @brief Size of the output buffer in bytes.
+ */
+#define OUTPUT_BUFFER_SIZE (1 << 20)
+
+/**
+ * @brief File name that selects the standard output.
+ */
+#define STANDARD_STREAM "-"
+
+/**
+ * @struct Output
+ *
+ * @brief Structure of an open output file and its buffer.
+ *
+ * fp is NULL for an output that only keeps its results in memory. written counts
+ * the bytes already written to the file. stream is set
+ * for the standard output, and hold while results must stay in memory until
+ * closeOutput because the standard output cannot be replaced atomically.
+ * fixed is set when the buffer belongs to the caller and must not grow.
+ * stats, when it is set, receives the time and the bytes of the writes.
+ */
+typedef struct output
+{
+    FILE *fp;
+    char *name;
+    char *writeName;
+    char *buffer;
+    size_t size;
+    size_t capacity;
+    size_t written;
+    int atomic;
+    int stream;
+    int hold;
+    int fixed;
+    Stats *stats;
+} Output;
+
+/**
+ * @brief Opens an output file and allocates its buffer.
+ *
+ * The file is truncated. When atomic is set the results are written to the
+ * file name with ".tmp" appended, which replaces the real file in closeOutput.
+ *
+ * The name "-" writes to the standard output. The standard output of the process
+ * is then redirected to the standard error, so messages printed with printf do
+ * not mix with the results. With atomic set the results are kept in memory
+ * and written only when the run succeeds.
+ *
+ * @param out Double pointer to the output that will be allocated.
+ * @param fileName Name of the output file.
+ * @param atomic Non zero to replace the file only when the run succeeds.
+ * @return int Returns EXIT_SUCCESS on success or EXIT_FAILURE on failure.
+ */
+int openOutput(Output **out, char *fileName, int atomic);
+
+/**
+ * @brief Opens an output file to append results after its first bytes.
+ *
+ * The bytes of the file after the first length bytes are cut off, so the
+ * results of a run that was stopped after a checkpoint are written again.
+ *
+ * @param out Double pointer to the output that will be allocated.
+ * @param fileName Name of the output file.
+ * @param length The number of bytes of the file that are kept.
+ * @return int Returns EXIT_SUCCESS on success or EXIT_FAILURE on failure, or if the file is shorter.
+ */
+int openAppendOutput(Output **out, char *fileName, size_t length);
+
+/**
+ * @brief Creates an output that keeps its results in memory.
+ *
+ * The buffer grows as needed and is never written to a file. The results are
+ * read from buffer and size, and the output is emptied by setting size to 0.
+ *
+ * @param out Double pointer to the output that will be allocated.
+ * @return int Returns EXIT_SUCCESS on success or EXIT_FAILURE on failure.
+ */
+int openBufferOutput(Output **out);
+
+/**
+ * @brief Makes an output of a buffer given by the caller.
+ *
+ * Nothing is allocated, the output is not closed with closeOutput. Writes
+ * that do not fit in the buffer fail without a message.
+ *
+ * @param out Pointer to the output to initialize.
+ * @param buffer The buffer that receives the results.
+ * @param capacity The size of the buffer.
+ */
+void initFixedOutput(Output *out, char *buffer, size_t capacity);
+
+/**
+ * @brief Appends bytes to the output.
+ *
+ * The bytes are copied to the buffer, which is written to the file when it is full.
+ * Blocks larger than the buffer are written directly. An output without a file
+ * grows its buffer instead, unless the buffer is fixed.
+ *
+ * @param out Pointer of output.
+ * @param data The bytes to write.
+ * @param length The number of bytes.
+ * @return int Returns EXIT_SUCCESS on success or EXIT_FAILURE on failure.
+ */
+int writeOutput(Output *out, const char *data, size_t length);
+
+/**
+ * @brief Appends a null terminated string to the output.
+ *
+ * @param out Pointer of output.
+ * @param data The string to write.
+ * @return int Returns EXIT_SUCCESS on success or EXIT_FAILURE on failure.
+ */
+int writeString(Output *out, const char *data);
+
+/**
+ * @brief Appends an integer and a new line to the output.
+ *
+ * @param out Pointer of output.
+ * @param number The number to write.
+ * @return int Returns EXIT_SUCCESS on success or EXIT_FAILURE on failure.
+ */
+int writeNumber(Output *out, long long number);
+
+/**
+ * @brief Appends an integer to the output.
+ *
+ * @param out Pointer of output.
+ * @param number The number to write.
+ * @return int Returns EXIT_SUCCESS on success or EXIT_FAILURE on failure.
+ */
+int writeInteger(Output *out, long long number);
+
+/**
+ * @brief Writes bytes straight to the file of the output.
+ *
+ * With stats set the time of the write and its bytes are added to them.
+ *
+ * @param out Pointer of output.
+ * @param data The bytes to write.
+ * @param length The number of bytes.
+ * @return int Returns EXIT_SUCCESS on success or EXIT_FAILURE on failure.
+ */
+int writeFile(Output *out, const char *data, size_t length);
+
+/**
+ * @brief Writes the buffered bytes to the file.
+ *
+ * @param out Pointer of output.
+ * @return int Returns EXIT_SUCCESS on success or EXIT_FAILURE on failure.
+ */
+int flushOutput(Output *out);
+
+/**
+ * @brief Writes the buffered bytes to the file and waits until they are on the disk.
+ *
+ * @param out Pointer of output.
+ * @return int Returns EXIT_SUCCESS on success or EXIT_FAILURE on failure.
+ */
+int syncOutput(Output *out);
+
+/**
+ * @brief Flushes and closes the output and frees it from the memory.
+ *
+ * With the atomic option the written file is renamed to the output file
+ * when status is EXIT_SUCCESS and removed otherwise.
+ *
+ * @param out Pointer of output.
+ * @param status The status of the run so far.
+ * @return int EXIT_SUCCESS if the output is complete, EXIT_FAILURE otherwise.
+ */
+int closeOutput(Output *out, int status);
+
+#endif
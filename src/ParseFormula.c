@@ -10,13 +10,50 @@
  * chemical formulas. The chemical formulas are processed according to
  * user commands to produce output files with the results.
  *
+ * Compiled with PARSE_FORMULA_LIBRARY the file has no main, so other programs
+ * such as the benchmarks can link the file modes. The parsing of one formula
+ * is in Formula.c.
+ *
  * @author Nicolas Constantinou
  * @date 23/10/2024
  */
 #include "Stack.h"
 #include "periodicTable.h"
+#include "Output.h"
+#include "LineReader.h"
+#include "Balance.h"
 #include "ParseFormula.h"
+#include "Batch.h"
+#include "Server.h"
+#include "FormulaHeader.h"
+#include "Jobs.h"
 
+/**
+ * @brief Help printed for wrong command line arguments.
+ */
+#define USAGE "Wrong arguments! try:\n" \
+              "1. ./parseFormula inputFile.txt -ext testFile.txt outputFile.txt [--atomic] [-j N]\n" \
+              "2. ./parseFormula inputFile.txt -pn testFile.txt outputFile.txt [--atomic] [-j N]\n" \
+              "3. ./parseFormula inputFile.txt -counts testFile.txt outputFile.txt [--empirical] [--atomic] [-j N]\n" \
+              "4. ./parseFormula inputFile.txt -mass testFile.txt outputFile.txt [--atomic] [-j N]\n" \
+              "5. ./parseFormula inputFile.txt -v testFile.txt\n" \
+              "   ./parseFormula inputFile.txt -bytecode testFile.txt formulas.fbc [--atomic] [-j N]\n" \
+              "   ./parseFormula inputFile.txt -ext|-pn|-counts|-mass|-bytecode -batch out/%%s.txt files... [@list.txt] [-j N]\n" \
+              "6. ./parseFormula inputFile.txt -compile table.bin\n" \
+              "   ./parseFormula inputFile.txt -header formulas.txt formulas.h\n" \
+              "7. ./parseFormula inputFile.txt -serve socketPath [--cache-mb N] [--max-atoms N]\n" \
+              "8. ./parseFormula socketPath -client -ext|-pn|-counts|-mass testFile.txt outputFile.txt\n" \
+              "   ./parseFormula socketPath -client -v testFile.txt\n" \
+              "   ./parseFormula socketPath -client -stats\n" \
+              "Use - as testFile.txt or outputFile.txt for the standard input or output.\n" \
+              "A bytecode file of -bytecode may be given as testFile.txt to 1-4.\n" \
+              "Add --max-atoms N to 1-4 to reject a formula of more than N atoms before it is expanded,\n" \
+              "to 7 to take formulas of up to N atoms in place of 16777216.\n" \
+              "Add --incremental to 1-4 to process only the lines added since the last run and append their results.\n" \
+              "Add --cache-mb N to 1-3 to reuse the results of repeated formulas in N MiB of memory.\n" \
+              "Add --stats to print the timings and counters of the run as JSON to the standard error.\n"
+
+#ifndef PARSE_FORMULA_LIBRARY
 /**
  * @brief Main entry for chemical formula parser.
  *
@@ -30,570 +67,301 @@
  */
 int main(int argc, char *argv[])
 {
+    Options options;
+    options.atomic = 0;
+    options.threads = 1;
+    options.empirical = 0;
+    options.cacheBytes = 0;
+    options.maxAtoms = 0;
+    options.incremental = 0;
+    options.stats = NULL;
+    options.name = NULL;
 
-    if (argc != 4 && argc != 5)
-    {
-        printf("Wrong arguments! try:\n1. ./parseFormula inputFile.txt -ext testFile.txt outputFile.txt\n2. ./parseFormula inputFile.txt -pn testFile.txt outputFile.txt\n3. ./parseFormula inputFile.txt -v testFile.txt\n");
-        return -1;
-    }
-
-    PeriodicTable *table = NULL;
-    if ((table = getTable(argv[1])) == NULL)
+    /* options may appear anywhere, the remaining arguments keep their positions */
+    int count = 0;
+    int counting = 0;
+    for (int i = 0; i < argc; i++)
     {
-        printf("Wrong input given from files!\n");
-        return -1;
-    }
-
-    if (strcmp(argv[2], "-ext") == 0 && argc == 5)
-    {
-        if (vTableForOthers(argv[3]) == EXIT_FAILURE)
+        if (strcmp(argv[i], "--atomic") == 0)
         {
-            printf("Not valid parenthesis!\n");
-            freeTable(table);
-            return -1;
+            options.atomic = 1;
         }
-        if (extTable(argv[3], argv[4], table) == EXIT_FAILURE)
+        else if (strcmp(argv[i], "--empirical") == 0)
         {
-            printf("Wrong input given from files!\n");
-            freeTable(table);
-            return -1;
+            options.empirical = 1;
         }
-    }
-    else if (strcmp(argv[2], "-pn") == 0 && argc == 5)
-    {
-        if (vTableForOthers(argv[3]) == EXIT_FAILURE)
+        else if (strcmp(argv[i], "--incremental") == 0)
         {
-            printf("Not valid parenthesis!\n");
-            freeTable(table);
-            return -1;
+            options.incremental = 1;
         }
-        if (pnTable(argv[3], table, argv[4]) == EXIT_FAILURE)
+        else if (strcmp(argv[i], "--stats") == 0)
         {
-            printf("Wrong input given from files!\n");
-            freeTable(table);
-            return -1;
+            counting = 1;
+        }
+        else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+        {
+            options.threads = atoi(argv[++i]);
+            if (options.threads < 1 || options.threads > MAX_THREADS)
+            {
+                printf("The number of threads must be from 1 to %d!\n", MAX_THREADS);
+                return -1;
+            }
+        }
+        else if (strcmp(argv[i], "--cache-mb") == 0 && i + 1 < argc)
+        {
+            long megabytes = atol(argv[++i]);
+            if (megabytes < 1)
+            {
+                printf("The cache needs at least 1 MiB!\n");
+                return -1;
+            }
+            options.cacheBytes = (size_t)megabytes << 20;
+        }
+        else if (strcmp(argv[i], "--max-atoms") == 0 && i + 1 < argc)
+        {
+            options.maxAtoms = atoll(argv[++i]);
+            if (options.maxAtoms < 1)
+            {
+                printf("The atom budget must be at least 1!\n");
+                return -1;
+            }
+        }
+        else
+        {
+            argv[count++] = argv[i];
         }
     }
-    else if (strcmp(argv[2], "-v") == 0 && argc == 4)
+    argc = count;
+    if (options.incremental && options.atomic)
     {
-        if (vTable(argv[3]) == EXIT_FAILURE)
+        printf("--incremental appends to the output and cannot be used with --atomic!\n");
+        return -1;
+    }
+
+    /* a client needs no table, the server has it */
+    if (argc >= 4 && argc <= 6 && strcmp(argv[2], "-client") == 0)
+    {
+        if (runClient(argv[1], argv[3], argc > 4 ? argv[4] : NULL, argc > 5 ? argv[5] : NULL, &options) == EXIT_FAILURE)
         {
             printf("Wrong input given from files!\n");
-            freeTable(table);
             return -1;
         }
+        return 0;
     }
-    else
+
+    /* a batch has a pattern of the outputs and any number of input files */
+    int batch = argc >= 6 && strcmp(argv[3], "-batch") == 0;
+    if (!batch && argc != 4 && argc != 5)
     {
-        printf("Wrong arguments! try:\n1. ./parseFormula inputFile.txt -ext testFile.txt outputFile.txt\n2. ./parseFormula inputFile.txt -pn testFile.txt outputFile.txt\n3. ./parseFormula inputFile.txt -v testFile.txt\n");
-        freeTable(table);
+        printf(USAGE);
         return -1;
     }
 
-    freeTable(table);
-    return 0;
-}
-
-int extTable(char *fileName, char *outFileName, PeriodicTable *table)
-{
-
-    FILE *fp = NULL;
-    fp = fopen(fileName, "r");
-    if (fp == NULL)
+    Stats stats;
+    if (counting)
     {
-        printf("Could not open %s!\n", fileName);
-        return EXIT_FAILURE;
+        memset(&stats, 0, sizeof(Stats));
+        options.stats = &stats;
+        enableStats();
+        startTimer(&stats.total);
+        startTimer(&stats.load);
     }
-
-    FILE *outFile = NULL;
-    outFile = fopen(outFileName, "w");
-    if (outFile == NULL)
+    PeriodicTable *table = getTable(argv[1]);
+    if (options.stats != NULL)
     {
-        printf("Could not open %s!\n", outFileName);
-        return EXIT_FAILURE;
+        stopTimer(&stats.load);
     }
-    fclose(outFile);
-
-    char buffer[1024];
-    while (!feof(fp))
+    if (table == NULL)
     {
-        Stack *stack = NULL;
-        if (initStack(&stack) == EXIT_FAILURE)
-        {
-            fclose(fp);
-            return EXIT_FAILURE;
-        }
-        if (fgets(buffer, sizeof(buffer), fp) == NULL)
-        {
-            freeStack(stack);
-            break;
-        }
-        if (openMoleculeType(buffer, stack, table) == EXIT_FAILURE)
-        {
-            return EXIT_FAILURE;
-        }
-        if (printStack(stack, outFileName) == EXIT_FAILURE)
-        {
-            return EXIT_FAILURE;
-        }
-        freeStack(stack);
+        printf("Wrong input given from files!\n");
+        return -1;
     }
-    printf("Compute extended version of formulas in %s\n", fileName);
-    printf("Writing formulas to %s\n", outFileName);
-    fclose(fp);
-    return EXIT_SUCCESS;
-}
 
-int pnTable(char *fileName, PeriodicTable *table, char *outFileName)
-{
-    FILE *fp = NULL;
-    fp = fopen(fileName, "r");
-    if (fp == NULL)
+    int status = EXIT_SUCCESS;
+    if (batch)
     {
-        printf("Could not open %s!\n", fileName);
-        return EXIT_FAILURE;
+        status = runBatch(argv[2], argv[4], argv + 5, argc - 5, table, &options);
     }
-
-    FILE *outFile = NULL;
-    outFile = fopen(outFileName, "w");
-    if (outFile == NULL)
+    else if (strcmp(argv[2], "-ext") == 0 && argc == 5)
     {
-        printf("Could not open %s!\n", outFileName);
-        return EXIT_FAILURE;
+        status = extTable(argv[3], argv[4], table, &options);
     }
-    fclose(outFile);
-
-    char buffer[1024];
-    while (!feof(fp))
+    else if (strcmp(argv[2], "-pn") == 0 && argc == 5)
     {
-        Stack *stack = NULL;
-        if (initStack(&stack) == EXIT_FAILURE)
-        {
-            fclose(fp);
-            return EXIT_FAILURE;
-        }
-        if (fgets(buffer, sizeof(buffer), fp) == NULL)
+        status = pnTable(argv[3], table, argv[4], &options);
+    }
+    else if (strcmp(argv[2], "-counts") == 0 && argc == 5)
+    {
+        status = countsTable(argv[3], table, argv[4], &options);
+    }
+    else if (strcmp(argv[2], "-mass") == 0 && argc == 5)
+    {
+        status = massTable(argv[3], table, argv[4], &options);
+    }
+    else if (strcmp(argv[2], "-bytecode") == 0 && argc == 5)
+    {
+        status = bytecodeTable(argv[3], table, argv[4], &options);
+    }
+    else if (strcmp(argv[2], "-compile") == 0 && argc == 4)
+    {
+        if (options.stats != NULL)
         {
-            freeStack(stack);
-            break;
+            startTimer(&stats.write);
         }
-        if (openMoleculeType(buffer, stack, table) == EXIT_FAILURE)
+        status = saveTable(table, argv[3]);
+        if (options.stats != NULL)
         {
-            return EXIT_FAILURE;
+            stopTimer(&stats.write);
         }
-        if (printMoleculeNumber(stack, table, outFileName, fileName) == EXIT_FAILURE)
+        if (status == EXIT_SUCCESS)
         {
-            return EXIT_FAILURE;
+            printf("Compiled periodic table %s to %s\n", argv[1], argv[3]);
         }
-        freeStack(stack);
     }
-    printf("Compute total proton number of formulas in %s\n", fileName);
-    printf("Writing formulas to %s\n", outFileName);
-    fclose(fp);
-    return EXIT_SUCCESS;
-}
-
-int vTable(char *fileName)
-{
-    char testFile[1024];
-    strcpy(testFile, fileName);
-
-    FILE *fp = NULL;
-    fp = fopen(testFile, "r");
-    if (fp == NULL)
+    else if (strcmp(argv[2], "-header") == 0 && argc == 5)
     {
-        printf("Could not open %s!\n", fileName);
-        return EXIT_FAILURE;
-    }
-    printf("Verify balanced parentheses in %s\n", testFile);
-
-    char buffer[1024];
-    int line = 1;
-    int valid = 1;
-    while (!feof(fp))
-    {
-        if (fgets(buffer, sizeof(buffer), fp) == NULL)
-        {
-            break;
-        }
-        if (checkValidity(buffer) == EXIT_FAILURE)
+        status = writeFormulaHeader(argv[3], argv[4], table);
+        if (status == EXIT_SUCCESS)
         {
-            printf("Parentheses NOT balanced in line: %d\n", line);
-            valid = 0;
+            printf("Generated the results of formulas in %s to %s\n", argv[3], argv[4]);
         }
-        line++;
     }
-    if (valid == 1)
+    else if (strcmp(argv[2], "-v") == 0 && argc == 4)
     {
-        printf("Parentheses are balanced for all chemical formulas\n");
+        status = vTable(argv[3], &options);
     }
-
-    fclose(fp);
-    return EXIT_SUCCESS;
-}
-
-int vTableForOthers(char *fileName)
-{
-    char testFile[1024];
-    strcpy(testFile, fileName);
-
-    FILE *fp = NULL;
-    fp = fopen(testFile, "r");
-    if (fp == NULL)
+    else if (strcmp(argv[2], "-serve") == 0 && argc == 4)
     {
-        printf("Could not open %s!\n", fileName);
-        return EXIT_FAILURE;
+        status = runServer(argv[3], table, &options);
+    }
+    else
+    {
+        printf(USAGE);
+        freeTable(table);
+        return -1;
     }
 
-    char buffer[1024];
-    int line = 1;
-    int valid = 1;
-    while (!feof(fp))
+    if (status == EXIT_FAILURE)
     {
-        if (fgets(buffer, sizeof(buffer), fp) == NULL)
-        {
-            break;
-        }
-        if (checkValidity(buffer) == EXIT_FAILURE)
-        {
-            valid = 0;
-        }
-        line++;
+        printf("Wrong input given from files!\n");
     }
-    fclose(fp);
-    if (valid == 1)
+    freeTable(table);
+    if (options.stats != NULL)
     {
-        return EXIT_SUCCESS;
+        stopTimer(&stats.total);
+        printStats(&stats, argv[2], options.threads, status);
     }
-    return EXIT_FAILURE;
+    return status == EXIT_SUCCESS ? 0 : -1;
 }
+#endif
 
-int checkValidity(char *buffer)
+int extTable(char *fileName, char *outFileName, PeriodicTable *table, Options *options)
 {
-    Stack *stack = NULL;
-    if (initStack(&stack) == EXIT_FAILURE)
+    if (processFile(fileName, outFileName, table, options, MODE_EXT) == EXIT_FAILURE)
     {
         return EXIT_FAILURE;
     }
-    for (int i = 0; i < strlen(buffer) - 1; i++)
-    {
-        if (buffer[i] == '(')
-        {
-            if (push(stack, "(") == EXIT_FAILURE)
-            {
-                freeStack(stack);
-                return EXIT_FAILURE;
-            }
-        }
-        if (buffer[i] == ')')
-        {
-            if (stack->size == 0)
-            {
-                freeStack(stack);
-                return EXIT_FAILURE;
-            }
-            char retval[1024];
-            if (pop(stack, retval) == EXIT_FAILURE)
-            {
-                if (stack != NULL)
-                {
-                    freeStack(stack);
-                }
-                free(buffer);
-                return EXIT_FAILURE;
-            }
-            if (strcmp(retval, ")") == 0)
-            {
-                freeStack(stack);
-                return EXIT_FAILURE;
-            }
-        }
-    }
-    if (stack->size > 0)
+    printf("Compute extended version of formulas in %s\n", fileName);
+    printf("Writing formulas to %s\n", outFileName);
+    return EXIT_SUCCESS;
+}
+
+int pnTable(char *fileName, PeriodicTable *table, char *outFileName, Options *options)
+{
+    if (processFile(fileName, outFileName, table, options, MODE_PN) == EXIT_FAILURE)
     {
-        freeStack(stack);
         return EXIT_FAILURE;
     }
-    freeStack(stack);
+    printf("Compute total proton number of formulas in %s\n", fileName);
+    printf("Writing formulas to %s\n", outFileName);
     return EXIT_SUCCESS;
 }
 
-int printMoleculeNumber(Stack *stack, PeriodicTable *table, char *outFileName, char *fileName)
+int countsTable(char *fileName, PeriodicTable *table, char *outFileName, Options *options)
 {
-
-    Stack *extraStack = NULL;
-    initStack(&extraStack);
-
-    FILE *outFile = NULL;
-    outFile = fopen(outFileName, "a");
-    if (outFile == NULL)
+    if (processFile(fileName, outFileName, table, options, MODE_COUNTS) == EXIT_FAILURE)
     {
-        printf("Could not open %s!\n", outFileName);
-        freeStack(extraStack);
         return EXIT_FAILURE;
     }
+    printf("Compute element counts of formulas in %s\n", fileName);
+    printf("Writing formulas to %s\n", outFileName);
+    return EXIT_SUCCESS;
+}
 
-    char retval[1024];
-    int moleculeNumber = 0;
-    while (stack->size > 0)
+int massTable(char *fileName, PeriodicTable *table, char *outFileName, Options *options)
+{
+    if (!hasMasses(table))
     {
-        if (pop(stack, retval) == EXIT_FAILURE)
-        {
-            fclose(outFile);
-            freeStack(extraStack);
-            return EXIT_FAILURE;
-        }
-        if (push(extraStack, retval) == EXIT_FAILURE)
-        {
-            fclose(outFile);
-            freeStack(extraStack);
-            return EXIT_FAILURE;
-        }
+        printf("The periodic table has no mass columns!\n");
+        return EXIT_FAILURE;
     }
-
-    while (extraStack->size > 0)
+    if (processFile(fileName, outFileName, table, options, MODE_MASS) == EXIT_FAILURE)
     {
-        if (pop(extraStack, retval) == EXIT_FAILURE)
-        {
-            fclose(outFile);
-            freeStack(extraStack);
-            return EXIT_FAILURE;
-        }
-        moleculeNumber += getMoleculeNumber(retval, table);
+        return EXIT_FAILURE;
     }
-    fprintf(outFile, "%d\n", moleculeNumber);
-
-    freeStack(extraStack);
-    fclose(outFile);
+    printf("Compute molar and monoisotopic masses of formulas in %s\n", fileName);
+    printf("Writing formulas to %s\n", outFileName);
     return EXIT_SUCCESS;
 }
 
-int openMoleculeType(char *buffer, Stack *stack, PeriodicTable *table)
+int bytecodeTable(char *fileName, PeriodicTable *table, char *outFileName, Options *options)
 {
-
-    for (int i = 0; i < strlen(buffer); i++)
+    if (processFile(fileName, outFileName, table, options, MODE_BYTECODE) == EXIT_FAILURE)
     {
-
-        if (buffer[i] >= 'A' && buffer[i] <= 'Z')
-        {
-            char molecule[1024];
-            int count = 0;
-            molecule[count] = buffer[i];
-            if (buffer[i + 1] >= 'a' && buffer[i + 1] <= 'z')
-            {
-                count++;
-                i++;
-                while (buffer[i] >= 'a' && buffer[i] <= 'z')
-                {
-                    molecule[count] = buffer[i];
-                    i++;
-                    count++;
-                }
-                i--;
-                count--;
-            }
-            molecule[count + 1] = '\0';
-            if (isMolecule(molecule, table) == EXIT_SUCCESS)
-            {
-                if (push(stack, molecule) == EXIT_FAILURE)
-                {
-                    return EXIT_FAILURE;
-                }
-            }
-            else
-            {
-                return EXIT_FAILURE;
-            }
-        }
-
-        else if (buffer[i] == '(')
-        {
-            if (push(stack, "(") == EXIT_FAILURE)
-            {
-                return EXIT_FAILURE;
-            }
-        }
-
-        else if (buffer[i] == ')')
-        {
-            char retval[1024];
-            char buffer2[1024];
-            int times = 0;
-            if (i + 1 < strlen(buffer) && ((buffer[i + 1]) - '0') >= 0 && ((buffer[i + 1]) - '0') <= 9)
-            {
-                i++;
-                times = findNumber(buffer, &i);
-                i--;
-            }
-            else
-            {
-                times = 1;
-            }
-            char hold[1024];
-            if (pop(stack, retval) == EXIT_FAILURE)
-            {
-                return EXIT_FAILURE;
-            }
-            strcpy(buffer2, retval);
-            if (pop(stack, retval) == EXIT_FAILURE)
-            {
-                return EXIT_FAILURE;
-            }
-            while (strcmp(retval, "(") != 0)
-            {
-                strcpy(hold, buffer2);
-                strcat(retval, hold);
-                strcpy(buffer2, retval);
-                if (pop(stack, retval) == EXIT_FAILURE)
-                {
-                    return EXIT_FAILURE;
-                }
-            }
-            for (int count = 0; count < times; count++)
-            {
-                if (push(stack, buffer2) == EXIT_FAILURE)
-                {
-                    return EXIT_FAILURE;
-                }
-            }
-        }
-
-        else if (((buffer[i]) - '0') >= 0 && ((buffer[i]) - '0') <= 9)
-        {
-            int times = 0;
-            if (i + 1 < strlen(buffer) && ((buffer[i + 1]) - '0') >= 0 && ((buffer[i + 1]) - '0') <= 9)
-            {
-                times = findNumber(buffer, &i);
-                i--;
-            }
-            else
-            {
-                times = buffer[i] - '0';
-            }
-            char retval[1024];
-            if (pop(stack, retval) == EXIT_FAILURE)
-            {
-                return EXIT_FAILURE;
-            }
-            for (int count = 0; count < times; count++)
-            {
-                if (push(stack, retval) == EXIT_FAILURE)
-                {
-                    return EXIT_FAILURE;
-                }
-            }
-        }
-        else if (buffer[i] >= 'a' && buffer[i] <= 'z')
-        {
-            return EXIT_FAILURE;
-        }
+        return EXIT_FAILURE;
     }
+    printf("Compile formulas in %s to bytecode\n", fileName);
+    printf("Writing bytecode to %s\n", outFileName);
     return EXIT_SUCCESS;
 }
 
-int printStack(Stack *stack, char *outFileName)
+int vTable(char *fileName, Options *options)
 {
-    Stack *extraStack = NULL;
-    if (initStack(&extraStack) == EXIT_FAILURE)
+    printf("Verify balanced parentheses in %s\n", fileName);
+    BalanceScan scan;
+    initBalanceScan(&scan, 1);
+    if (options->stats != NULL)
     {
-        return EXIT_FAILURE;
+        startTimer(&options->stats->parse);
     }
-
-    FILE *outFile = NULL;
-    outFile = fopen(outFileName, "a");
-    if (outFile == NULL)
+    int status = scanFile(fileName, &scan);
+    if (options->stats != NULL)
     {
-        printf("Could not open %s!\n", outFileName);
-        freeStack(extraStack);
-        return EXIT_FAILURE;
+        stopTimer(&options->stats->parse);
+        options->stats->lines = scan.line - 1;
+        options->stats->bytesIn = scan.bytes;
     }
-
-    char retval[1024];
-    while (stack->size > 0)
+    if (status == EXIT_FAILURE)
     {
-        if (pop(stack, retval) == EXIT_FAILURE)
-        {
-            freeStack(extraStack);
-            fclose(outFile);
-            return EXIT_FAILURE;
-        }
-        if (push(extraStack, retval) == EXIT_FAILURE)
-        {
-            freeStack(extraStack);
-            fclose(outFile);
-            return EXIT_FAILURE;
-        }
+        return EXIT_FAILURE;
     }
-
-    while (extraStack->size > 0)
+    if (scan.invalid == 0)
     {
-        if (pop(extraStack, retval) == EXIT_FAILURE)
-        {
-            freeStack(extraStack);
-            fclose(outFile);
-            return EXIT_FAILURE;
-        }
-        fprintf(outFile, "%s", retval);
+        printf("Parentheses are balanced for all chemical formulas\n");
     }
-    fprintf(outFile, "\n");
-
-    freeStack(extraStack);
-    fclose(outFile);
     return EXIT_SUCCESS;
 }
 
-int getMoleculeNumber(char *buffer, PeriodicTable *table)
+int scanFile(char *fileName, BalanceScan *scan)
 {
-    int number = 0;
-    for (int i = 0; i < strlen(buffer); i++)
+    LineReader *reader = NULL;
+    if (openReader(&reader, fileName) == EXIT_FAILURE)
     {
-
-        if (buffer[i] >= 'A' && buffer[i] <= 'Z')
-        {
-            char molecule[1024];
-            int count = 0;
-            molecule[count] = buffer[i];
-            if (i + 1 < strlen(buffer) && buffer[i + 1] >= 'a' && buffer[i + 1] <= 'z')
-            {
-                count++;
-                i++;
-                while (buffer[i] >= 'a' && buffer[i] <= 'z')
-                {
-                    molecule[count] = buffer[i];
-                    i++;
-                    count++;
-                }
-                i--;
-                count--;
-            }
-            molecule[count + 1] = '\0';
-            number += findMoleculeNumber(molecule, table);
-        }
+        return EXIT_FAILURE;
     }
-    return number;
-}
-
-int findMoleculeNumber(char *molecule, PeriodicTable *table)
-{
-    for (int i = 0; i < table->size; i++)
+    char *block = NULL;
+    size_t length = 0;
+    int status = 0;
+    while ((status = nextBlock(reader, BALANCE_BLOCK_SIZE, &block, &length)) == 1)
     {
-        if (strcmp(molecule, table->array[i].name) == 0)
-        {
-            return table->array[i].periodicNum;
-        }
+        scanBalance(scan, block, length);
+        scan->bytes += length;
     }
-    return 0;
-}
-
-int findNumber(char *buffer, int *index)
-{
-    int num = 0;
-
-    while (isdigit(buffer[*index]))
+    finishBalance(scan);
+    closeReader(reader);
+    if (status < 0)
     {
-        num = num * 10 + (buffer[*index] - '0');
-        (*index)++;
+        return EXIT_FAILURE;
     }
-
-    return num;
+    return EXIT_SUCCESS;
 }
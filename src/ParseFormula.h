@@ -18,136 +18,125 @@
 
 #include <ctype.h>
 
+#include "Stats.h"
+#include "Formula.h"
+
+/**
+ * @struct Options
+ *
+ * @brief Command line options shared by the parsing modes.
+ */
+typedef struct options
+{
+    int atomic;        /**< Write nothing unless every formula is valid. */
+    int threads;       /**< Number of worker threads of -ext, -pn and -counts. */
+    int empirical;     /**< Reduce -counts output to the empirical formula. */
+    size_t cacheBytes; /**< Memory of the result cache, 0 without a cache. */
+    long long maxAtoms; /**< Most atoms of a formula, 0 without a limit. */
+    int incremental;   /**< Go on from the checkpoint of the output and append to it. */
+    Stats *stats;      /**< Statistics of the run, NULL without --stats. */
+    char *name;        /**< Input file named in the messages of a batch, NULL otherwise. */
+} Options;
+
 /**
  * @brief Computes the extended version of chemical formulas from a file.
  *
  * This function reads chemical formulas from an input file, expands them
  * by resolving groups and parentheses, and writes the expanded formula to an output file.
+ * The parentheses of every line are checked in the same pass. Processing stops at the
+ * first unbalanced line; with the atomic option the output file is then left untouched.
+ * The lines are processed by options->threads workers, see processFile.
  *
  * @param fileName Name of the input file with chemical formulas.
  * @param outFileName Name of the output file to write expanded formulas.
  * @param table Pointer to the periodic table structure.
+ * @param options Pointer to the command line options.
  * @return int EXIT_SUCCESS on success, EXIT_FAILURE on error.
  */
-int extTable(char *fileName, char *outFileName, PeriodicTable *table);
+int extTable(char *fileName, char *outFileName, PeriodicTable *table, Options *options);
 
 /**
  * @brief Computes total proton number for each formula in the file.
  *
  * This function calculates the total number of protons for each chemical formula
- * in an input file and writes the results to an output file.
+ * in an input file and writes the results to an output file. The parentheses are
+ * checked in the same pass, as in extTable.
  *
  * @param fileName Name of the input file with chemical formulas.
  * @param table Pointer to the periodic table structure.
  * @param outFileName Name of the output file to write proton numbers.
+ * @param options Pointer to the command line options.
  * @return int EXIT_SUCCESS on success, EXIT_FAILURE on error.
  */
-int pnTable(char *fileName, PeriodicTable *table, char *outFileName);
-
-/**
- * @brief Verifies balanced parentheses in chemical formulas.
- *
- * This function checks if the parentheses in each formula in a file are balanced.
- * It reports whether each line passes or fails the validation.
- *
- * @param fileName Name of the file with chemical formulas.
- * @return int EXIT_SUCCESS if balanced, EXIT_FAILURE if unbalanced.
- */
-int vTable(char *fileName);
-
-/**
- * @brief Verifies balanced parentheses in a file without outputting line information.
- *
- * This function validates if the parentheses in each formula are balanced.
- * Used for preprocessing to check formula validity before further parsing.
- *
- * @param fileName Name of the input file with formulas.
- * @return int EXIT_SUCCESS if all formulas are balanced, EXIT_FAILURE otherwise.
- */
-int vTableForOthers(char *fileName);
-
-/**
- * @brief Checks if parentheses in a formula are balanced.
- *
- * This function uses a stack to ensure all opening and closing parentheses
- * are correctly balanced within a single chemical formula string.
- *
- * @param buffer The chemical formula string.
- * @return int EXIT_SUCCESS if balanced, EXIT_FAILURE if unbalanced.
- */
-int checkValidity(char *buffer);
-
-/**
- * @brief Computes total proton number for a formula from the stack.
- *
- * Calculates the total proton count for a formula by using the atomic number of each element in the formula.
- *
- * @param stack Pointer to the stack with elements of the formula.
- * @param table Pointer to the periodic table.
- * @param outFileName Name of the output file for results.
- * @param fileName Name of the input file for error reporting.
- * @return int EXIT_SUCCESS on success, EXIT_FAILURE on error.
- */
-int printMoleculeNumber(Stack *stack, PeriodicTable *table, char *outFileName, char *fileName);
+int pnTable(char *fileName, PeriodicTable *table, char *outFileName, Options *options);
 
 /**
- * @brief Parses a single molecule type from a formula string.
+ * @brief Computes the element counts of every formula in the file in Hill notation.
  *
- * This function scans a chemical formula string for molecule symbols and numbers,
- * correctly grouping and counting elements using a stack.
+ * The counts are computed with countTokens, without expanding the formulas,
+ * and written with printHillFormula. The parentheses are checked in the same pass,
+ * as in extTable.
  *
- * @param buffer The formula string.
- * @param stack Pointer to the stack used for processing formula elements.
+ * @param fileName Name of the input file with chemical formulas.
  * @param table Pointer to the periodic table structure.
+ * @param outFileName Name of the output file to write the condensed formulas.
+ * @param options Pointer to the command line options.
  * @return int EXIT_SUCCESS on success, EXIT_FAILURE on error.
  */
-int openMoleculeType(char *buffer, Stack *stack, PeriodicTable *table);
+int countsTable(char *fileName, PeriodicTable *table, char *outFileName, Options *options);
 
 /**
- * @brief Prints the contents of the stack to a file.
+ * @brief Computes the molar and the monoisotopic mass of every formula in the file.
  *
- * Writes each element in the stack to an output file in reverse order,
- * reconstructing the chemical formula structure.
+ * The counts are computed with countTokens, without expanding the formulas,
+ * and the masses with computeMasses for batches of formulas. Every line of the
+ * output holds the average mass and the exact mass. The table must have mass columns.
  *
- * @param stack Pointer to the stack with elements to print.
- * @param outFileName Name of the output file to write the formula.
+ * @param fileName Name of the input file with chemical formulas.
+ * @param table Pointer to the periodic table structure.
+ * @param outFileName Name of the output file to write the masses.
+ * @param options Pointer to the command line options.
  * @return int EXIT_SUCCESS on success, EXIT_FAILURE on error.
  */
-int printStack(Stack *stack, char *outFileName);
+int massTable(char *fileName, PeriodicTable *table, char *outFileName, Options *options);
 
 /**
- * @brief Retrieves atomic number for a molecule in a formula.
+ * @brief Compiles every formula in the file to bytecode.
  *
- * This function sums atomic numbers from elements in the formula string
- * based on entries in the periodic table.
+ * The formulas are checked and read as by the other modes, and their tokens
+ * are written to a bytecode file, see Bytecode.h. -ext, -pn, -counts and -mass
+ * then take the bytecode file in place of the formulas.
  *
- * @param buffer Formula string containing the molecule symbols.
+ * @param fileName Name of the input file with chemical formulas.
  * @param table Pointer to the periodic table structure.
- * @return int The total atomic number sum for the formula.
+ * @param outFileName Name of the bytecode file.
+ * @param options Pointer to the command line options.
+ * @return int EXIT_SUCCESS on success, EXIT_FAILURE on error.
  */
-int getMoleculeNumber(char *buffer, PeriodicTable *table);
+int bytecodeTable(char *fileName, PeriodicTable *table, char *outFileName, Options *options);
 
 /**
- * @brief Finds the atomic number of a molecule in the periodic table.
+ * @brief Verifies balanced parentheses in chemical formulas.
  *
- * Looks up the atomic number of a molecule by name in the periodic table.
+ * This function checks if the parentheses in each formula in a file are balanced.
+ * It reports every line that fails the validation with its first offending column:
+ * the close parenthesis without an open one, or the open parenthesis never closed.
  *
- * @param molecule Name of the molecule.
- * @param table Pointer to the periodic table.
- * @return int The atomic number of the molecule or 0 if not found.
+ * @param fileName Name of the file with chemical formulas.
+ * @param options Pointer to the command line options.
+ * @return int EXIT_SUCCESS if balanced, EXIT_FAILURE if unbalanced.
  */
-int findMoleculeNumber(char *molecule, PeriodicTable *table);
+int vTable(char *fileName, Options *options);
 
 /**
- * @brief Parses an integer from a formula string at a given position.
+ * @brief Checks the parentheses of every line of a file with scanBalance.
  *
- * This function extracts a multi-digit integer from a formula string
- * starting at a given index.
+ * The file is read in blocks of BALANCE_BLOCK_SIZE bytes of complete lines.
  *
- * @param buffer The formula string.
- * @param index Pointer to the current index in the string.
- * @return int The parsed integer value.
+ * @param fileName Name of the input file with formulas.
+ * @param scan Pointer to the state of the check, started with initBalanceScan.
+ * @return int EXIT_SUCCESS if the file was read, EXIT_FAILURE otherwise.
  */
-int findNumber(char *buffer, int *index);
+int scanFile(char *fileName, BalanceScan *scan);
 
 #endif
\ No newline at end of file
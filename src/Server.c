@@ -0,0 +1,621 @@
+/**
+ * @file Server.c
+ *
+ * @brief Daemon that answers formula requests over a Unix domain socket.
+ *
+ * @author Nicolas Constantinou
+ * @date 23/10/2024
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "Stack.h"
+#include "periodicTable.h"
+#include "Output.h"
+#include "LineReader.h"
+#include "Balance.h"
+#include "ParseFormula.h"
+#include "Batch.h"
+#include "Server.h"
+
+/**
+ * @brief Set by SIGINT or SIGTERM to stop accepting connections.
+ */
+static volatile sig_atomic_t stopping = 0;
+
+void stopServer(int signal)
+{
+    (void)signal;
+    stopping = 1;
+}
+
+int readFull(int fd, void *data, size_t length)
+{
+    size_t done = 0;
+    while (done < length)
+    {
+        ssize_t count = read(fd, (char *)data + done, length - done);
+        if (count < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (count <= 0)
+        {
+            return done == 0 && count == 0 ? 0 : -1;
+        }
+        done += (size_t)count;
+    }
+    return 1;
+}
+
+int writeFull(int fd, const void *data, size_t length)
+{
+    size_t done = 0;
+    while (done < length)
+    {
+        ssize_t count = write(fd, (const char *)data + done, length - done);
+        if (count < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (count <= 0)
+        {
+            return EXIT_FAILURE;
+        }
+        done += (size_t)count;
+    }
+    return EXIT_SUCCESS;
+}
+
+int openSocket(char *socketPath, struct sockaddr_un *address)
+{
+    if (strlen(socketPath) >= sizeof(address->sun_path))
+    {
+        printf("The socket path %s is too long!\n", socketPath);
+        return -1;
+    }
+    memset(address, 0, sizeof(struct sockaddr_un));
+    address->sun_family = AF_UNIX;
+    strcpy(address->sun_path, socketPath);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+    {
+        printf("Could not create a socket!\n");
+    }
+    return fd;
+}
+
+int writeServerStats(Server *server, Output *out)
+{
+    char line[512];
+    pthread_mutex_lock(&server->lock);
+    int length = snprintf(line, sizeof(line),
+                          "{\"uptime\":%.0f,\"connections\":%ld,\"active\":%ld,\"requests\":%ld,"
+                          "\"failedRequests\":%ld,\"lines\":%ld,\"bytesIn\":%llu,\"bytesOut\":%llu}\n",
+                          difftime(time(NULL), (time_t)server->started), server->connections, server->active,
+                          server->requests, server->failed, server->lines,
+                          (unsigned long long)server->bytesIn, (unsigned long long)server->bytesOut);
+    pthread_mutex_unlock(&server->lock);
+    if (length < 0 || (size_t)length >= sizeof(line))
+    {
+        return EXIT_FAILURE;
+    }
+    return writeOutput(out, line, (size_t)length);
+}
+
+int answerRequest(Connection *connection, RequestHeader *request, ResponseHeader *response, char **payload)
+{
+    Server *server = connection->server;
+    response->magic = SERVER_MAGIC;
+    response->status = RESPONSE_OK;
+    response->line = 0;
+    response->length = 0;
+    *payload = NULL;
+    long lines = 0;
+    int status = EXIT_SUCCESS;
+
+    if (request->magic != SERVER_MAGIC || request->mode > REQUEST_STATS || request->length > SERVER_MAX_REQUEST)
+    {
+        /* the rest of the stream cannot be framed any more */
+        response->status = RESPONSE_BAD_REQUEST;
+        status = EXIT_FAILURE;
+    }
+    else if (request->length > connection->capacity)
+    {
+        char *data = (char *)statsRealloc(connection->data, request->length);
+        if (data == NULL)
+        {
+            response->status = RESPONSE_ERROR;
+            status = EXIT_FAILURE;
+        }
+        else
+        {
+            connection->data = data;
+            connection->capacity = request->length;
+        }
+    }
+    if (status == EXIT_SUCCESS && request->length > 0 && readFull(connection->fd, connection->data, request->length) != 1)
+    {
+        return EXIT_FAILURE;
+    }
+
+    connection->report->size = 0;
+    if (status == EXIT_FAILURE)
+    {
+        /* nothing more to do */
+    }
+    else if (request->mode == REQUEST_STATS)
+    {
+        if (writeServerStats(server, connection->report) == EXIT_FAILURE)
+        {
+            response->status = RESPONSE_ERROR;
+        }
+        *payload = connection->report->buffer;
+        response->length = connection->report->size;
+    }
+    else if (request->mode == REQUEST_V)
+    {
+        BalanceScan scan;
+        initBalanceScan(&scan, 1);
+        scan.report = connection->report;
+        scan.line = request->firstLine > 0 ? (long)request->firstLine : 1;
+        long first = scan.line;
+        scanBalance(&scan, connection->data, request->length);
+        finishBalance(&scan);
+        lines = scan.line - first;
+        if (scan.invalid > 0)
+        {
+            response->status = RESPONSE_UNBALANCED;
+            response->line = scan.firstLine - first + 1;
+        }
+        *payload = connection->report->buffer;
+        response->length = connection->report->size;
+    }
+    else if (request->mode == REQUEST_MASS && !hasMasses(server->table))
+    {
+        response->status = RESPONSE_NO_MASSES;
+    }
+    else
+    {
+        int mode = (int)request->mode;
+        Worker *worker = &connection->workers[mode];
+        if (!connection->ready[mode])
+        {
+            if (initWorker(worker, server->table, mode, &server->options, NULL) == EXIT_FAILURE)
+            {
+                freeWorker(worker);
+                response->status = RESPONSE_ERROR;
+                mode = -1;
+            }
+            else
+            {
+                worker->maxOutput = SERVER_MAX_RESPONSE;
+                connection->ready[mode] = 1;
+            }
+        }
+        if (mode >= 0)
+        {
+            worker->data = connection->data;
+            worker->length = request->length;
+            runWorker(worker);
+            lines = worker->lines;
+            if (worker->failedLine > 0)
+            {
+                response->status = worker->unbalanced ? RESPONSE_UNBALANCED : worker->oversized ? RESPONSE_TOO_LARGE : RESPONSE_INVALID;
+                response->line = worker->failedLine;
+            }
+            *payload = worker->out->buffer;
+            response->length = worker->out->size;
+        }
+    }
+
+    pthread_mutex_lock(&server->lock);
+    server->requests++;
+    server->lines += lines;
+    if (response->status != RESPONSE_OK && request->mode != REQUEST_V)
+    {
+        server->failed++;
+    }
+    server->bytesIn += sizeof(RequestHeader) + (status == EXIT_SUCCESS ? request->length : 0);
+    server->bytesOut += sizeof(ResponseHeader) + response->length;
+    pthread_mutex_unlock(&server->lock);
+    return status;
+}
+
+void *serveConnection(void *arg)
+{
+    Connection *connection = (Connection *)arg;
+    RequestHeader request;
+    while (readFull(connection->fd, &request, sizeof(RequestHeader)) == 1)
+    {
+        ResponseHeader response;
+        char *payload = NULL;
+        int status = answerRequest(connection, &request, &response, &payload);
+        if (writeFull(connection->fd, &response, sizeof(ResponseHeader)) == EXIT_FAILURE ||
+            (response.length > 0 && writeFull(connection->fd, payload, response.length) == EXIT_FAILURE) ||
+            status == EXIT_FAILURE)
+        {
+            break;
+        }
+    }
+
+    for (int i = 0; i < 4; i++)
+    {
+        if (connection->ready[i])
+        {
+            freeWorker(&connection->workers[i]);
+        }
+    }
+    closeOutput(connection->report, EXIT_SUCCESS);
+    free(connection->data);
+
+    /* off the list before the socket is closed, so its number is not shut down again */
+    Server *server = connection->server;
+    pthread_mutex_lock(&server->lock);
+    if (connection->previous != NULL)
+    {
+        connection->previous->next = connection->next;
+    }
+    else
+    {
+        server->open = connection->next;
+    }
+    if (connection->next != NULL)
+    {
+        connection->next->previous = connection->previous;
+    }
+    if (--server->active == 0)
+    {
+        pthread_cond_signal(&server->idle);
+    }
+    pthread_mutex_unlock(&server->lock);
+    close(connection->fd);
+    free(connection);
+    return NULL;
+}
+
+void shutdownConnections(Server *server, int how)
+{
+    for (Connection *connection = server->open; connection != NULL; connection = connection->next)
+    {
+        shutdown(connection->fd, how);
+    }
+}
+
+int runServer(char *socketPath, PeriodicTable *table, Options *options)
+{
+    Server server;
+    memset(&server, 0, sizeof(Server));
+    server.table = table;
+    server.options = *options;
+    server.options.threads = 1;
+    server.options.stats = NULL;
+    /* a line like (H99999)99999 must not expand without bound in a daemon */
+    if (server.options.maxAtoms == 0)
+    {
+        server.options.maxAtoms = SERVER_MAX_ATOMS;
+    }
+    server.started = (double)time(NULL);
+    pthread_mutex_init(&server.lock, NULL);
+    pthread_cond_init(&server.idle, NULL);
+
+    struct sockaddr_un address;
+    server.listener = openSocket(socketPath, &address);
+    if (server.listener < 0)
+    {
+        return EXIT_FAILURE;
+    }
+    /* a socket file nobody answers on is left over from a server that died */
+    if (connect(server.listener, (struct sockaddr *)&address, sizeof(address)) == 0)
+    {
+        printf("A server is already running on %s!\n", socketPath);
+        close(server.listener);
+        return EXIT_FAILURE;
+    }
+    close(server.listener);
+    unlink(socketPath);
+    server.listener = openSocket(socketPath, &address);
+    if (server.listener < 0 || bind(server.listener, (struct sockaddr *)&address, sizeof(address)) != 0 ||
+        listen(server.listener, SOMAXCONN) != 0)
+    {
+        printf("Could not listen on %s!\n", socketPath);
+        if (server.listener >= 0)
+        {
+            close(server.listener);
+        }
+        return EXIT_FAILURE;
+    }
+
+    /* a second signal stops the server at once */
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = stopServer;
+    action.sa_flags = SA_RESETHAND;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    pthread_attr_t attributes;
+    pthread_attr_init(&attributes);
+    pthread_attr_setdetachstate(&attributes, PTHREAD_CREATE_DETACHED);
+    printf("Serving on %s\n", socketPath);
+    fflush(stdout);
+
+    int status = EXIT_SUCCESS;
+    while (!stopping)
+    {
+        int fd = accept(server.listener, NULL, NULL);
+        if (fd < 0)
+        {
+            if (errno != EINTR && errno != ECONNABORTED)
+            {
+                printf("Could not accept a connection!\n");
+                status = EXIT_FAILURE;
+                break;
+            }
+            continue;
+        }
+        Connection *connection = (Connection *)statsCalloc(1, sizeof(Connection));
+        if (connection == NULL || openBufferOutput(&connection->report) == EXIT_FAILURE)
+        {
+            free(connection);
+            close(fd);
+            continue;
+        }
+        connection->server = &server;
+        connection->fd = fd;
+        pthread_mutex_lock(&server.lock);
+        server.connections++;
+        server.active++;
+        connection->next = server.open;
+        if (server.open != NULL)
+        {
+            server.open->previous = connection;
+        }
+        server.open = connection;
+        pthread_mutex_unlock(&server.lock);
+        /* the signals stay with this thread, so they interrupt accept */
+        sigset_t signals;
+        sigset_t previous;
+        sigemptyset(&signals);
+        sigaddset(&signals, SIGINT);
+        sigaddset(&signals, SIGTERM);
+        pthread_sigmask(SIG_BLOCK, &signals, &previous);
+        pthread_t thread;
+        int created = pthread_create(&thread, &attributes, serveConnection, connection);
+        pthread_sigmask(SIG_SETMASK, &previous, NULL);
+        if (created != 0)
+        {
+            printf("Could not start a connection thread!\n");
+            pthread_mutex_lock(&server.lock);
+            server.active--;
+            server.open = connection->next;
+            if (server.open != NULL)
+            {
+                server.open->previous = NULL;
+            }
+            pthread_mutex_unlock(&server.lock);
+            closeOutput(connection->report, EXIT_SUCCESS);
+            free(connection);
+            close(fd);
+        }
+    }
+
+    close(server.listener);
+    unlink(socketPath);
+    /* idle clients read the end of the stream, busy ones first send their response */
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += SERVER_DRAIN_SECONDS;
+    pthread_mutex_lock(&server.lock);
+    shutdownConnections(&server, SHUT_RD);
+    while (server.active > 0)
+    {
+        if (pthread_cond_timedwait(&server.idle, &server.lock, &deadline) == ETIMEDOUT)
+        {
+            shutdownConnections(&server, SHUT_RDWR);
+            pthread_cond_wait(&server.idle, &server.lock);
+        }
+    }
+    pthread_mutex_unlock(&server.lock);
+    pthread_attr_destroy(&attributes);
+
+    Output *out = NULL;
+    if (openBufferOutput(&out) == EXIT_SUCCESS)
+    {
+        if (writeServerStats(&server, out) == EXIT_SUCCESS)
+        {
+            printf("Server stopped: %.*s", (int)out->size, out->buffer);
+        }
+        closeOutput(out, EXIT_SUCCESS);
+    }
+    pthread_cond_destroy(&server.idle);
+    pthread_mutex_destroy(&server.lock);
+    return status;
+}
+
+int sendRequest(int fd, uint32_t mode, uint64_t firstLine, const char *data, size_t length, ResponseHeader *response, char **payload, size_t *capacity)
+{
+    RequestHeader request;
+    request.magic = SERVER_MAGIC;
+    request.mode = mode;
+    request.firstLine = firstLine;
+    request.length = length;
+    if (writeFull(fd, &request, sizeof(RequestHeader)) == EXIT_FAILURE ||
+        (length > 0 && writeFull(fd, data, length) == EXIT_FAILURE) ||
+        readFull(fd, response, sizeof(ResponseHeader)) != 1 || response->magic != SERVER_MAGIC)
+    {
+        printf("The server closed the connection!\n");
+        return EXIT_FAILURE;
+    }
+    if (response->length > *capacity)
+    {
+        char *grown = (char *)statsRealloc(*payload, response->length);
+        if (grown == NULL)
+        {
+            printf("Could not allocate the response!\n");
+            return EXIT_FAILURE;
+        }
+        *payload = grown;
+        *capacity = response->length;
+    }
+    if (response->length > 0 && readFull(fd, *payload, response->length) != 1)
+    {
+        printf("The server closed the connection!\n");
+        return EXIT_FAILURE;
+    }
+    if (response->status == RESPONSE_NO_MASSES)
+    {
+        printf("The periodic table has no mass columns!\n");
+        return EXIT_FAILURE;
+    }
+    if (response->status == RESPONSE_BAD_REQUEST || response->status == RESPONSE_ERROR)
+    {
+        printf("The server could not answer the request!\n");
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+int runClient(char *socketPath, char *mode, char *fileName, char *outFileName, Options *options)
+{
+    const char *modes[] = {"-ext", "-pn", "-counts", "-mass", "-v", "-stats"};
+    uint32_t request = 0;
+    while (request <= REQUEST_STATS && strcmp(mode, modes[request]) != 0)
+    {
+        request++;
+    }
+    int needsOutput = request <= REQUEST_MASS;
+    if (request > REQUEST_STATS || (request == REQUEST_STATS) != (fileName == NULL) || needsOutput != (outFileName != NULL))
+    {
+        printf("Unknown request %s or wrong files for it!\n", mode);
+        return EXIT_FAILURE;
+    }
+
+    struct sockaddr_un address;
+    int fd = openSocket(socketPath, &address);
+    if (fd < 0)
+    {
+        return EXIT_FAILURE;
+    }
+    if (connect(fd, (struct sockaddr *)&address, sizeof(address)) != 0)
+    {
+        printf("Could not connect to the server on %s!\n", socketPath);
+        close(fd);
+        return EXIT_FAILURE;
+    }
+    signal(SIGPIPE, SIG_IGN);
+
+    ResponseHeader response;
+    char *payload = NULL;
+    size_t capacity = 0;
+    if (request == REQUEST_STATS)
+    {
+        int status = sendRequest(fd, request, 0, NULL, 0, &response, &payload, &capacity);
+        if (status == EXIT_SUCCESS && response.length > 0)
+        {
+            fwrite(payload, 1, response.length, stdout);
+        }
+        free(payload);
+        close(fd);
+        return status;
+    }
+
+    LineReader *reader = NULL;
+    Output *out = NULL;
+    if (openReader(&reader, fileName) == EXIT_FAILURE)
+    {
+        close(fd);
+        return EXIT_FAILURE;
+    }
+    if (needsOutput && openOutput(&out, outFileName, options->atomic) == EXIT_FAILURE)
+    {
+        closeReader(reader);
+        close(fd);
+        return EXIT_FAILURE;
+    }
+    if (request == REQUEST_V)
+    {
+        printf("Verify balanced parentheses in %s\n", fileName);
+    }
+
+    long line = 0;
+    int unbalanced = 0;
+    int status = EXIT_SUCCESS;
+    char *block = NULL;
+    size_t length = 0;
+    int more = 0;
+    while (status == EXIT_SUCCESS && (more = nextBlock(reader, CLIENT_BATCH_SIZE, &block, &length)) == 1)
+    {
+        status = sendRequest(fd, request, (uint64_t)line + 1, block, length, &response, &payload, &capacity);
+        if (status == EXIT_FAILURE)
+        {
+            break;
+        }
+        if (request == REQUEST_V)
+        {
+            if (response.length > 0)
+            {
+                fwrite(payload, 1, response.length, stdout);
+            }
+            unbalanced |= response.status == RESPONSE_UNBALANCED;
+        }
+        else if (writeOutput(out, payload, response.length) == EXIT_FAILURE)
+        {
+            status = EXIT_FAILURE;
+        }
+        else if (response.status != RESPONSE_OK)
+        {
+            if (response.status == RESPONSE_UNBALANCED)
+            {
+                printf("Not valid parenthesis in line: %ld\n", line + (long)response.line);
+            }
+            else if (response.status == RESPONSE_TOO_LARGE)
+            {
+                printf("Too many atoms in line: %ld\n", line + (long)response.line);
+            }
+            status = EXIT_FAILURE;
+        }
+        else if (out->stream)
+        {
+            status = flushOutput(out);
+        }
+
+        /* the last line of the file may have no new line */
+        for (char *next = block; (next = (char *)memchr(next, '\n', block + length - next)) != NULL; next++)
+        {
+            line++;
+        }
+        if (length > 0 && block[length - 1] != '\n')
+        {
+            line++;
+        }
+    }
+    if (more < 0)
+    {
+        status = EXIT_FAILURE;
+    }
+
+    if (out != NULL)
+    {
+        status = closeOutput(out, status);
+    }
+    closeReader(reader);
+    free(payload);
+    close(fd);
+    if (status == EXIT_SUCCESS && request == REQUEST_V && !unbalanced)
+    {
+        printf("Parentheses are balanced for all chemical formulas\n");
+    }
+    else if (status == EXIT_SUCCESS && needsOutput)
+    {
+        printf("Compute %s of formulas in %s on the server %s\n", mode, fileName, socketPath);
+        printf("Writing formulas to %s\n", outFileName);
+    }
+    return status;
+}
@@ -0,0 +1,267 @@
+/**
+ * @file Server.h
+ *
+ * @brief Daemon that answers formula requests over a Unix domain socket.
+ *
+ * The server loads the periodic table once and listens on a local socket.
+ * Every connection gets a thread of its own, with a worker per mode that is
+ * kept for all the requests of the connection, so requests are answered
+ * concurrently while the table is shared read-only.
+ *
+ * A request is a RequestHeader followed by length bytes of formulas, one per
+ * line, and is answered by a ResponseHeader followed by length bytes of
+ * results, the same bytes the mode writes to its output file. The fields are
+ * in the byte order of the host, as both ends run on the same machine. A
+ * connection may send any number of requests, one after the other.
+ *
+ * @author Nicolas Constantinou
+ * @date 23/10/2024
+ */
+#ifndef Server_h
+#define Server_h
+
+#include <stdint.h>
+#include <pthread.h>
+#include <sys/un.h>
+
+/**
+ * @brief First field of every request and response, "PFS1".
+ */
+#define SERVER_MAGIC 0x31534650u
+
+/**
+ * @brief Largest number of bytes of formulas in one request.
+ */
+#define SERVER_MAX_REQUEST (64u << 20)
+
+/**
+ * @brief Bytes of formulas the client sends per request.
+ */
+#define CLIENT_BATCH_SIZE (1 << 20)
+
+/**
+ * @brief Most atoms of a formula the server takes when --max-atoms is not given.
+ */
+#define SERVER_MAX_ATOMS (1LL << 24)
+
+/**
+ * @brief Bytes of results after which a request is answered with RESPONSE_TOO_LARGE.
+ */
+#define SERVER_MAX_RESPONSE ((size_t)256 << 20)
+
+/**
+ * @brief Seconds the open connections get to finish their requests when the server stops.
+ */
+#define SERVER_DRAIN_SECONDS 5
+
+#define REQUEST_EXT 0
+#define REQUEST_PN 1
+#define REQUEST_COUNTS 2
+#define REQUEST_MASS 3
+#define REQUEST_V 4
+#define REQUEST_STATS 5
+
+#define RESPONSE_OK 0
+#define RESPONSE_INVALID 1
+#define RESPONSE_UNBALANCED 2
+#define RESPONSE_BAD_REQUEST 3
+#define RESPONSE_ERROR 4
+#define RESPONSE_TOO_LARGE 5
+#define RESPONSE_NO_MASSES 6
+
+/**
+ * @struct RequestHeader
+ *
+ * @brief Header of a request.
+ *
+ * mode is one of the REQUEST values. firstLine is the number of the first
+ * line of the request in the whole input, used in the -v messages.
+ */
+typedef struct requestHeader
+{
+    uint32_t magic;
+    uint32_t mode;
+    uint64_t firstLine;
+    uint64_t length;
+} RequestHeader;
+
+/**
+ * @struct ResponseHeader
+ *
+ * @brief Header of a response.
+ *
+ * status is one of the RESPONSE values. line is the line, counted from 1
+ * within the request, that failed or, for REQUEST_V, the first line that is
+ * not balanced. The results of the lines before it are in the response.
+ */
+typedef struct responseHeader
+{
+    uint32_t magic;
+    uint32_t status;
+    uint64_t line;
+    uint64_t length;
+} ResponseHeader;
+
+/**
+ * @struct Server
+ *
+ * @brief State shared by the connections of a server.
+ *
+ * The counters and the list of open connections are changed under lock.
+ * active is the number of open connections, idle is signaled when it drops to 0.
+ */
+typedef struct server
+{
+    struct connection *open;
+    PeriodicTable *table;
+    Options options;
+    int listener;
+    pthread_mutex_t lock;
+    pthread_cond_t idle;
+    double started;
+    long connections;
+    long active;
+    long requests;
+    long failed;
+    long lines;
+    uint64_t bytesIn;
+    uint64_t bytesOut;
+} Server;
+
+/**
+ * @struct Connection
+ *
+ * @brief One client of the server, served by a thread of its own.
+ *
+ * next and previous link the open connections of the server.
+ */
+typedef struct connection
+{
+    Server *server;
+    struct connection *next;
+    struct connection *previous;
+    int fd;
+    Worker workers[4];
+    int ready[4];
+    Output *report;
+    char *data;
+    size_t capacity;
+} Connection;
+
+/**
+ * @brief Signal handler that stops the server after the current accept.
+ *
+ * @param signal The signal number.
+ */
+void stopServer(int signal);
+
+/**
+ * @brief Creates a Unix domain socket and the address of a path.
+ *
+ * @param socketPath Path of the socket.
+ * @param address Pointer to the address to fill.
+ * @return int The socket, or -1 on error.
+ */
+int openSocket(char *socketPath, struct sockaddr_un *address);
+
+/**
+ * @brief Answers requests until SIGINT or SIGTERM, with the table already loaded.
+ *
+ * The socket file is created at socketPath, replacing a stale one, and removed
+ * when the server stops. The open connections then get SERVER_DRAIN_SECONDS
+ * to finish their requests before their sockets are shut down, and the server
+ * prints its counters. Without --max-atoms a formula may have SERVER_MAX_ATOMS.
+ *
+ * @param socketPath Path of the socket.
+ * @param table Pointer to the periodic table shared by the connections.
+ * @param options Pointer to the command line options, --cache-mb gives every connection a cache.
+ * @return int EXIT_SUCCESS on success, EXIT_FAILURE on error.
+ */
+int runServer(char *socketPath, PeriodicTable *table, Options *options);
+
+/**
+ * @brief Shuts down the sockets of the open connections, with the lock of the server held.
+ *
+ * @param server Pointer to the server.
+ * @param how SHUT_RD to let the requests being answered finish, SHUT_RDWR to stop them.
+ */
+void shutdownConnections(Server *server, int how);
+
+/**
+ * @brief Answers the requests of one connection until it is closed.
+ *
+ * @param connection Pointer to the connection, passed as void* to be a thread function.
+ * @return void* Always NULL.
+ */
+void *serveConnection(void *connection);
+
+/**
+ * @brief Computes the response to one request.
+ *
+ * @param connection Pointer to the connection.
+ * @param request Pointer to the header of the request.
+ * @param response Pointer to the header of the response to fill.
+ * @param payload Pointer that receives the results.
+ * @return int EXIT_SUCCESS on success, EXIT_FAILURE when the connection must be closed.
+ */
+int answerRequest(Connection *connection, RequestHeader *request, ResponseHeader *response, char **payload);
+
+/**
+ * @brief Writes the counters of a server as one line of JSON.
+ *
+ * @param server Pointer to the server.
+ * @param out Pointer to the output that receives the line.
+ * @return int EXIT_SUCCESS on success, EXIT_FAILURE on error.
+ */
+int writeServerStats(Server *server, Output *out);
+
+/**
+ * @brief Sends one request and reads its response.
+ *
+ * @param fd The socket connected to the server.
+ * @param mode One of the REQUEST values.
+ * @param firstLine Number of the first line of the request in the whole input.
+ * @param data The formulas, one per line.
+ * @param length The number of bytes of the formulas.
+ * @param response Pointer to the header of the response.
+ * @param payload Pointer to the buffer of the results, grown as needed.
+ * @param capacity Pointer to the size of the buffer.
+ * @return int EXIT_SUCCESS when the response was read and the server could answer, EXIT_FAILURE otherwise.
+ */
+int sendRequest(int fd, uint32_t mode, uint64_t firstLine, const char *data, size_t length, ResponseHeader *response, char **payload, size_t *capacity);
+
+/**
+ * @brief Sends a file to a server in requests of complete lines and writes the results.
+ *
+ * A failed line is reported as by the modes run without a server.
+ *
+ * @param socketPath Path of the socket of the server.
+ * @param mode The mode: -ext, -pn, -counts, -mass, -v or -stats.
+ * @param fileName Name of the input file, NULL for -stats.
+ * @param outFileName Name of the output file, NULL for -v and -stats.
+ * @param options Pointer to the command line options.
+ * @return int EXIT_SUCCESS on success, EXIT_FAILURE on error.
+ */
+int runClient(char *socketPath, char *mode, char *fileName, char *outFileName, Options *options);
+
+/**
+ * @brief Reads exactly length bytes from a socket.
+ *
+ * @param fd The socket.
+ * @param data The buffer.
+ * @param length The number of bytes.
+ * @return int 1 on success, 0 if the socket was closed before the first byte, -1 on error.
+ */
+int readFull(int fd, void *data, size_t length);
+
+/**
+ * @brief Writes exactly length bytes to a socket.
+ *
+ * @param fd The socket.
+ * @param data The bytes.
+ * @param length The number of bytes.
+ * @return int EXIT_SUCCESS on success, EXIT_FAILURE on error.
+ */
+int writeFull(int fd, const void *data, size_t length);
+
+#endif
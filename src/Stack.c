@@ -7,136 +7,113 @@
  * @date 23/10/2024
  */
 #include "Stack.h"
+#include <limits.h>
+#include "Stats.h"
 
-int initStack(Stack **stack)
+int initTokenStack(TokenStack **stack)
 {
-    (*stack) = (Stack *)malloc(sizeof(Stack));
+    (*stack) = (TokenStack *)statsMalloc(sizeof(TokenStack));
     if ((*stack) == NULL)
     {
-        printf("Could not allocate the stack!\n");
+        printf("Could not allocate the token stack!\n");
         return EXIT_FAILURE;
     }
-    (*stack)->top = NULL;
     (*stack)->size = 0;
+    (*stack)->capacity = 64;
+    (*stack)->array = (Token *)statsMalloc(sizeof(Token) * (*stack)->capacity);
+    if ((*stack)->array == NULL)
+    {
+        printf("Could not allocate the tokens of the token stack!\n");
+        free(*stack);
+        return EXIT_FAILURE;
+    }
     return EXIT_SUCCESS;
 }
 
-int push(Stack *s, char *value)
+int reserveTokens(TokenStack *stack, int size)
 {
-    Node *p = NULL;
-    if (s == NULL)
+    if (size < 0 || stack->size > INT_MAX - size)
     {
-        printf("Stack is NULL!\n");
         return EXIT_FAILURE;
     }
-
-    p = (Node *)malloc(sizeof(Node));
-    if (p == NULL)
+    if (stack->size + size <= stack->capacity)
     {
-        printf("Could not allocate the new node!\n");
-        return EXIT_FAILURE;
+        return EXIT_SUCCESS;
     }
-    p->data = (char *)malloc(strlen(value) + 1);
-    if ((p->data) == NULL)
+    long capacity = stack->capacity > 0 ? stack->capacity : 1;
+    while (capacity < stack->size + size)
+    {
+        capacity *= 2;
+    }
+    if (capacity > INT_MAX)
+    {
+        capacity = INT_MAX;
+    }
+    Token *array = (Token *)statsRealloc(stack->array, sizeof(Token) * capacity);
+    if (array == NULL)
     {
-        printf("Could not allocate the name of the node!\n");
         return EXIT_FAILURE;
     }
-    strcpy((p->data), value);
-    p->next = s->top;
-    s->top = p;
-    (s->size)++;
+    stack->array = array;
+    stack->capacity = (int)capacity;
     return EXIT_SUCCESS;
 }
 
-int pop(Stack *s, char *retval)
+int pushToken(TokenStack *stack, int id, int count)
 {
-    Node *p = NULL;
-    if (s == NULL || s->size == 0)
+    if (stack->size == stack->capacity && reserveTokens(stack, 1) == EXIT_FAILURE)
     {
-        printf("Sorry, stack is empty!\n");
         return EXIT_FAILURE;
     }
-
-    if (retval == NULL)
-    {
-        printf("Retval is null!\n");
-        return EXIT_FAILURE;
-    }
-    strcpy(retval, (s->top)->data);
-    p = s->top;
-    s->top = p->next;
-    (s->size)--;
-    free(p->data);
-    free(p);
+    stack->array[stack->size].id = id;
+    stack->array[stack->size].count = count;
+    (stack->size)++;
     return EXIT_SUCCESS;
 }
 
-void freeStack(Stack *stack)
+void freeTokenStack(TokenStack *stack)
 {
-    Node *cur = stack->top;
-    Node *temp = NULL;
-
-    while (cur != NULL)
-    {
-        temp = cur;
-        cur = cur->next;
-        free(temp->data);
-        free(temp);
-    }
+    free(stack->array);
     free(stack);
 }
 
 #ifdef DEBUG
 /**
- * @brief Main function for testing the stack functions.
+ * @brief Main function for testing the token stack functions.
  *
- * This function tests the stack functions by initializing a stack,
- * pushing elements onto it, popping elements off, and printing them.
+ * This function tests the token stack functions by initializing a stack,
+ * pushing tokens onto it past its first capacity, and printing them.
  * It lastly frees them from the memory.
  *
  * @return int Returns 0 on success or -1 on failure.
  */
 int main(void)
 {
-    Stack *s = NULL;
-    if (initStack(&s) == EXIT_FAILURE)
+    TokenStack *s = NULL;
+    if (initTokenStack(&s) == EXIT_FAILURE)
     {
-        printf("unable to initialize stack!\n");
+        printf("unable to initialize token stack!\n");
         return -1;
     }
 
-    char *input = NULL;
-    for (char ch = 'A'; ch <= 'F'; ch++)
+    for (int i = 0; i < 100; i++)
     {
-        input = (char *)malloc(2);
-        char buf[2];
-        buf[0] = ch;
-        buf[1] = '\0';
-        strcpy(input, buf);
-        if (push(s, input) == EXIT_FAILURE)
+        if (pushToken(s, i % 3 == 0 ? TOKEN_OPEN : i, i) == EXIT_FAILURE)
         {
-            printf("push function failed...\n");
+            printf("pushToken function failed...\n");
+            freeTokenStack(s);
             return -1;
         }
-        free(input);
     }
 
-    char *retval = NULL;
-    while (s->size > 0)
+    for (int i = s->size - 1; i >= 0; i--)
     {
-        retval = (char *)malloc(2);
-        if (pop(s, retval) == EXIT_FAILURE)
-        {
-            printf("pop function failed...\n");
-            return -1;
-        }
-        printf("%s has been popped\n", retval);
-        free(retval);
+        printf("token %d: id %d, count %d\n", i, s->array[i].id, s->array[i].count);
     }
+    printf("%d tokens in a capacity of %d\n", s->size, s->capacity);
 
-    freeStack(s);
-    printf("Stack free from memory!\n");
+    freeTokenStack(s);
+    printf("Token stack free from memory!\n");
     return 0;
 }
-#endif
\ No newline at end of file
+#endif
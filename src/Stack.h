@@ -1,7 +1,7 @@
 /**
  * @file Stack.h
  *
- * @brief Stack function prototypes push, pop, initialization and free.
+ * @brief Token stack function prototypes push, initialization and free.
  *
  * @author Nicolas Constantinou
  * @date 23/10/2024
@@ -15,67 +15,71 @@
 #include <ctype.h>
 
 /**
- * @struct Node
+ * @struct Token
  *
- * @brief Structure of an element in the stack.
+ * @brief Compact element of a formula: an element with its repeat count or a parenthesis.
+ *
+ * For an element id is its index in the periodic table. An open parenthesis has id
+ * TOKEN_OPEN and, once its group is closed, the position of the closing token as count.
+ * A closing parenthesis has id TOKEN_CLOSE and the multiplier of the group as count.
  */
-typedef struct node
+typedef struct token
 {
-    char *data;
-    struct node *next;
-} Node;
+    int id;
+    int count;
+} Token;
+
+#define TOKEN_OPEN -1
+#define TOKEN_CLOSE -2
 
 /**
- * @struct Stack
+ * @struct TokenStack
  *
- * @brief Structure of stack to hold elements.
+ * @brief Growable array of tokens used as a stack, the top is array[size - 1].
  */
-typedef struct stack
+typedef struct tokenStack
 {
-    struct node *top;
+    Token *array;
     int size;
-} Stack;
+    int capacity;
+} TokenStack;
 
 /**
- * @brief Creates a new stack.
- *
- * This function allocates memory for a new stack, its top to NULL and its size to 0.
- * If memory allocation fails, prints error and returns failure.
+ * @brief Creates a new token stack.
  *
- * @param stack Double pointer to the stack that will be initialized and memory allocated.
+ * @param stack Double pointer to the token stack that will be allocated.
  * @return int Returns EXIT_SUCCESS on success or EXIT_FAILURE on failure.
  */
-int initStack(Stack **stack);
+int initTokenStack(TokenStack **stack);
 
 /**
- * @brief Pushes a new element on the stack.
+ * @brief Makes room for more tokens on the token stack.
  *
- * This function takes a value and pushes it on the top of the stack.
+ * The array grows by doubling until it can hold size more tokens. An empty
+ * stack with no array may grow too. Nothing is printed on failure, the caller
+ * reports it, so the parsing functions stay silent for the library.
  *
- * @param s Pointer of stack.
- * @param value The data to push on the stack.
+ * @param stack Pointer of token stack.
+ * @param size The number of tokens that will be pushed.
  * @return int Returns EXIT_SUCCESS on success or EXIT_FAILURE on failure.
  */
-int push(Stack *stack, char *value);
+int reserveTokens(TokenStack *stack, int size);
 
 /**
- * @brief Pops the top element from the stack and returns its data.
+ * @brief Pushes a new token on the token stack.
  *
- * This function removes the top element from the stack and returns its data.
- *
- * @param s Pointer of stack.
- * @param retval Pointer to store the data of the popped element.
- * @return int Returns EXIT_SUCCESS on success or EXIT_FAILURE if the stack is empty or another error occurs.
+ * @param stack Pointer of token stack.
+ * @param id The element index of the token or TOKEN_OPEN.
+ * @param count The repeat count of the element.
+ * @return int Returns EXIT_SUCCESS on success or EXIT_FAILURE on failure.
  */
-int pop(Stack *stack, char *retval);
+int pushToken(TokenStack *stack, int id, int count);
 
 /**
- * @brief Frees the stack and its nodes from the memory.
- *
- * This function frees all nodes in the stack, including their data, and lastly frees the stack itself.
+ * @brief Frees the token stack and its array from the memory.
  *
- * @param stack Pointer of stack.
+ * @param stack Pointer of token stack.
  */
-void freeStack(Stack *stack);
+void freeTokenStack(TokenStack *stack);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,117 @@
+/**
+ * @file Stats.c
+ *
+ * @brief Run statistics printed by --stats.
+ *
+ * @author Nicolas Constantinou
+ * @date 23/10/2024
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <time.h>
+#include <pthread.h>
+#include "Stats.h"
+
+/**
+ * @brief Allocation counters of the whole program, shared by the threads.
+ */
+static int enabled = 0;
+static long allocations = 0;
+static size_t allocatedBytes = 0;
+static pthread_mutex_t allocationLock = PTHREAD_MUTEX_INITIALIZER;
+
+void enableStats(void)
+{
+    enabled = 1;
+}
+
+void countAllocation(size_t size)
+{
+    pthread_mutex_lock(&allocationLock);
+    allocations++;
+    allocatedBytes += size;
+    pthread_mutex_unlock(&allocationLock);
+}
+
+void *statsMalloc(size_t size)
+{
+    if (enabled)
+    {
+        countAllocation(size);
+    }
+    return malloc(size);
+}
+
+void *statsCalloc(size_t count, size_t size)
+{
+    if (enabled)
+    {
+        countAllocation(count * size);
+    }
+    return calloc(count, size);
+}
+
+void *statsRealloc(void *memory, size_t size)
+{
+    if (enabled)
+    {
+        countAllocation(size);
+    }
+    return realloc(memory, size);
+}
+
+void startTimer(Timer *timer)
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    timer->startWall = (double)time.tv_sec + (double)time.tv_nsec / 1e9;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &time);
+    timer->startCpu = (double)time.tv_sec + (double)time.tv_nsec / 1e9;
+}
+
+void stopTimer(Timer *timer)
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    timer->wall += (double)time.tv_sec + (double)time.tv_nsec / 1e9 - timer->startWall;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &time);
+    timer->cpu += (double)time.tv_sec + (double)time.tv_nsec / 1e9 - timer->startCpu;
+}
+
+void mergeStats(Stats *total, Stats *part)
+{
+    total->pushes += part->pushes;
+    total->pops += part->pops;
+    if (part->peakDepth > total->peakDepth)
+    {
+        total->peakDepth = part->peakDepth;
+    }
+}
+
+void printStats(Stats *stats, const char *mode, int threads, int status)
+{
+    /* the write time was spent inside the parse phase */
+    double parseWall = stats->parse.wall - stats->write.wall;
+    double parseCpu = stats->parse.cpu - stats->write.cpu;
+    pthread_mutex_lock(&allocationLock);
+    long count = allocations;
+    size_t bytes = allocatedBytes;
+    pthread_mutex_unlock(&allocationLock);
+
+    fprintf(stderr,
+            "{\"mode\":\"%s\",\"threads\":%d,\"status\":\"%s\","
+            "\"phases\":{\"load\":{\"wall\":%.6f,\"cpu\":%.6f},"
+            "\"parse\":{\"wall\":%.6f,\"cpu\":%.6f},"
+            "\"write\":{\"wall\":%.6f,\"cpu\":%.6f},"
+            "\"total\":{\"wall\":%.6f,\"cpu\":%.6f}},"
+            "\"lines\":%ld,\"bytesIn\":%zu,\"bytesOut\":%zu,"
+            "\"pushes\":%ld,\"pops\":%ld,\"peakDepth\":%d,"
+            "\"mallocs\":%ld,\"mallocBytes\":%zu}\n",
+            mode, threads, status == EXIT_SUCCESS ? "ok" : "failed",
+            stats->load.wall, stats->load.cpu,
+            parseWall > 0 ? parseWall : 0, parseCpu > 0 ? parseCpu : 0,
+            stats->write.wall, stats->write.cpu,
+            stats->total.wall, stats->total.cpu,
+            stats->lines, stats->bytesIn, stats->bytesOut,
+            stats->pushes, stats->pops, stats->peakDepth,
+            count, bytes);
+}
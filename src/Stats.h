@@ -0,0 +1,129 @@
+/**
+ * @file Stats.h
+ *
+ * @brief Run statistics printed by --stats.
+ *
+ * A run is split in phases: loading the table, parsing the formulas and
+ * writing the results. Every phase keeps its wall time and the CPU time of
+ * the whole process. The workers count their own formulas, stack operations
+ * and depth, which are added together at the end of a run, and every
+ * allocation of the program goes through statsMalloc, statsCalloc or
+ * statsRealloc. Without --stats nothing is timed or counted, apart from one
+ * test per allocation and per formula.
+ *
+ * @author Nicolas Constantinou
+ * @date 23/10/2024
+ */
+#ifndef Stats_h
+#define Stats_h
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+/**
+ * @struct Timer
+ *
+ * @brief Wall and CPU seconds summed over the intervals of a phase.
+ */
+typedef struct timer
+{
+    double wall;
+    double cpu;
+    double startWall;
+    double startCpu;
+} Timer;
+
+/**
+ * @struct Stats
+ *
+ * @brief Timings and counters of a run, or the counters of one worker.
+ *
+ * The parse timer covers the whole processing of the input, the write time
+ * spent in it is subtracted when the statistics are printed.
+ */
+typedef struct stats
+{
+    Timer load;
+    Timer parse;
+    Timer write;
+    Timer total;
+    long lines;
+    size_t bytesIn;
+    size_t bytesOut;
+    long pushes;
+    long pops;
+    int peakDepth;
+} Stats;
+
+/**
+ * @brief Starts counting the allocations of the program.
+ */
+void enableStats(void);
+
+/**
+ * @brief Allocates memory like malloc and counts it when the statistics are enabled.
+ *
+ * @param size The number of bytes.
+ * @return void* The memory, or NULL on failure.
+ */
+void *statsMalloc(size_t size);
+
+/**
+ * @brief Allocates zeroed memory like calloc and counts it when the statistics are enabled.
+ *
+ * @param count The number of elements.
+ * @param size The size of an element.
+ * @return void* The memory, or NULL on failure.
+ */
+void *statsCalloc(size_t count, size_t size);
+
+/**
+ * @brief Resizes memory like realloc and counts it when the statistics are enabled.
+ *
+ * @param memory The memory to resize, or NULL.
+ * @param size The new number of bytes.
+ * @return void* The memory, or NULL on failure.
+ */
+void *statsRealloc(void *memory, size_t size);
+
+/**
+ * @brief Adds an allocation to the counters.
+ *
+ * @param size The number of bytes allocated.
+ */
+void countAllocation(size_t size);
+
+/**
+ * @brief Starts an interval of a timer.
+ *
+ * @param timer Pointer to the timer.
+ */
+void startTimer(Timer *timer);
+
+/**
+ * @brief Ends an interval of a timer and adds it to the timer.
+ *
+ * @param timer Pointer to the timer.
+ */
+void stopTimer(Timer *timer);
+
+/**
+ * @brief Adds the counters of a worker to the statistics of a run.
+ *
+ * @param total Pointer to the statistics of the run.
+ * @param part Pointer to the counters of the worker.
+ */
+void mergeStats(Stats *total, Stats *part);
+
+/**
+ * @brief Prints the statistics of a run as one line of JSON to the standard error.
+ *
+ * @param stats Pointer to the statistics.
+ * @param mode The mode of the run, such as "-pn".
+ * @param threads The number of worker threads.
+ * @param status EXIT_SUCCESS or EXIT_FAILURE, the result of the run.
+ */
+void printStats(Stats *stats, const char *mode, int threads, int status);
+
+#endif
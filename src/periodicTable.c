@@ -7,177 +7,783 @@
  * @author Nicolas Constantinou
  * @date 23/10/2024
  */
+#define _POSIX_C_SOURCE 200809L
+#include <ctype.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "periodicTable.h"
+#include "LineReader.h"
+#include "Stats.h"
+
+/**
+ * @brief Number of elements of the embedded standard table.
+ */
+#define DEFAULT_SIZE 118
+
+/**
+ * @brief Names of the embedded standard table, sorted by atomic number.
+ */
+static const char *defaultNames[DEFAULT_SIZE] = {
+    "H", "He", "Li", "Be", "B", "C", "N", "O", "F", "Ne", "Na", "Mg", "Al", "Si", "P",
+    "S", "Cl", "Ar", "K", "Ca", "Sc", "Ti", "V", "Cr", "Mn", "Fe", "Co", "Ni", "Cu",
+    "Zn", "Ga", "Ge", "As", "Se", "Br", "Kr", "Rb", "Sr", "Y", "Zr", "Nb", "Mo", "Tc",
+    "Ru", "Rh", "Pd", "Ag", "Cd", "In", "Sn", "Sb", "Te", "I", "Xe", "Cs", "Ba", "La",
+    "Ce", "Pr", "Nd", "Pm", "Sm", "Eu", "Gd", "Tb", "Dy", "Ho", "Er", "Tm", "Yb", "Lu",
+    "Hf", "Ta", "W", "Re", "Os", "Ir", "Pt", "Au", "Hg", "Tl", "Pb", "Bi", "Po", "At",
+    "Rn", "Fr", "Ra", "Ac", "Th", "Pa", "U", "Np", "Pu", "Am", "Cm", "Bk", "Cf", "Es",
+    "Fm", "Md", "No", "Lr", "Rf", "Db", "Sg", "Bh", "Hs", "Mt", "Ds", "Rg", "Cn", "Uut",
+    "Fl", "Uup", "Lv", "Uus", "Uuo"};
+
+/**
+ * @brief Atomic numbers of the embedded standard table.
+ */
+static const int defaultNumbers[DEFAULT_SIZE] = {
+    1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23,
+    24, 25, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40, 41, 42, 43, 44,
+    45, 46, 47, 48, 49, 50, 51, 52, 53, 54, 55, 56, 57, 58, 59, 60, 61, 62, 63, 64, 65,
+    66, 67, 68, 69, 70, 71, 72, 73, 74, 75, 76, 77, 78, 79, 80, 81, 82, 83, 84, 85, 86,
+    87, 88, 89, 90, 91, 92, 93, 94, 95, 96, 97, 98, 99, 100, 101, 102, 103, 104, 105,
+    106, 107, 108, 109, 110, 111, 112, 113, 114, 115, 116, 117, 118};
+
+/**
+ * @brief Standard atomic weights of the embedded standard table, the mass number
+ * of the longest lived isotope for elements without a standard weight.
+ */
+static const double defaultAverageMasses[DEFAULT_SIZE] = {
+    1.008, 4.0026, 6.94, 9.0122, 10.81, 12.011, 14.007, 15.999, 18.998, 20.180,
+    22.990, 24.305, 26.982, 28.085, 30.974, 32.06, 35.45, 39.95, 39.098, 40.078,
+    44.956, 47.867, 50.942, 51.996, 54.938, 55.845, 58.933, 58.693, 63.546, 65.38,
+    69.723, 72.630, 74.922, 78.971, 79.904, 83.798, 85.468, 87.62, 88.906, 91.224,
+    92.906, 95.95, 97.0, 101.07, 102.91, 106.42, 107.87, 112.41, 114.82, 118.71,
+    121.76, 127.60, 126.90, 131.29, 132.91, 137.33, 138.91, 140.12, 140.91, 144.24,
+    145.0, 150.36, 151.96, 157.25, 158.93, 162.50, 164.93, 167.26, 168.93, 173.05,
+    174.97, 178.49, 180.95, 183.84, 186.21, 190.23, 192.22, 195.08, 196.97, 200.59,
+    204.38, 207.2, 208.98, 209.0, 210.0, 222.0, 223.0, 226.0, 227.0, 232.04,
+    231.04, 238.03, 237.0, 244.0, 243.0, 247.0, 247.0, 251.0, 252.0, 257.0,
+    258.0, 259.0, 262.0, 267.0, 268.0, 269.0, 270.0, 269.0, 278.0, 281.0,
+    282.0, 285.0, 286.0, 289.0, 290.0, 293.0, 294.0, 294.0};
+
+/**
+ * @brief Monoisotopic masses of the embedded standard table, the mass of the most
+ * abundant or longest lived isotope.
+ */
+static const double defaultExactMasses[DEFAULT_SIZE] = {
+    1.00782503, 4.00260325, 7.01600344, 9.01218307, 11.00930536, 12.0,
+    14.00307401, 15.99491462, 18.99840316, 19.99244018, 22.98976928, 23.98504170,
+    26.98153853, 27.97692653, 30.97376200, 31.97207117, 34.96885268, 39.96238312,
+    38.96370649, 39.96259086, 44.95590828, 47.94794198, 50.94395704, 51.94050623,
+    54.93804391, 55.93493633, 58.93319429, 57.93534241, 62.92959772, 63.92914201,
+    68.92557350, 73.92117776, 74.92159457, 79.91652180, 78.91833760, 83.91149773,
+    84.91178974, 87.90561226, 88.90584030, 89.90469876, 92.90637300, 97.90540482,
+    96.90636670, 101.90434410, 102.90549800, 105.90348040, 106.90509160, 113.90336509,
+    114.90387878, 119.90220163, 120.90381200, 129.90622275, 126.90447190, 131.90415509,
+    132.90545196, 137.90524700, 138.90635630, 139.90544310, 140.90765760, 141.90772900,
+    144.91275590, 151.91973970, 152.92123800, 157.92411230, 158.92535470, 163.92918190,
+    164.93032880, 165.93029950, 168.93421790, 173.93886640, 174.94077520, 179.94655700,
+    180.94799580, 183.95093092, 186.95575010, 191.96147700, 192.96292160, 194.96479170,
+    196.96656879, 201.97064340, 204.97442780, 207.97665250, 208.98039910, 208.98243080,
+    209.98714790, 222.01757820, 223.01973600, 226.02541030, 227.02775230, 232.03805580,
+    231.03588420, 238.05078840, 237.04817360, 244.06420530, 243.06138130, 247.07035410,
+    247.07030730, 251.07958860, 252.08298000, 257.09510610, 258.09843150, 259.10103000,
+    262.10961000, 267.12179000, 268.12567000, 269.12863000, 270.13336000, 269.13375000,
+    278.15631000, 281.16451000, 282.16912000, 285.17712000, 286.18221000, 289.19042000,
+    290.19598000, 293.20449000, 294.21046000, 294.21392000};
+
+/**
+ * @brief Symbol index of the embedded standard table, resolved at compile time.
+ */
+static const short defaultIndex[SYMBOL_KEYS] = {
+    [SYMBOL_KEY('H', 0, 0)] = 1,
+    [SYMBOL_KEY('H', 'e', 0)] = 2,
+    [SYMBOL_KEY('L', 'i', 0)] = 3,
+    [SYMBOL_KEY('B', 'e', 0)] = 4,
+    [SYMBOL_KEY('B', 0, 0)] = 5,
+    [SYMBOL_KEY('C', 0, 0)] = 6,
+    [SYMBOL_KEY('N', 0, 0)] = 7,
+    [SYMBOL_KEY('O', 0, 0)] = 8,
+    [SYMBOL_KEY('F', 0, 0)] = 9,
+    [SYMBOL_KEY('N', 'e', 0)] = 10,
+    [SYMBOL_KEY('N', 'a', 0)] = 11,
+    [SYMBOL_KEY('M', 'g', 0)] = 12,
+    [SYMBOL_KEY('A', 'l', 0)] = 13,
+    [SYMBOL_KEY('S', 'i', 0)] = 14,
+    [SYMBOL_KEY('P', 0, 0)] = 15,
+    [SYMBOL_KEY('S', 0, 0)] = 16,
+    [SYMBOL_KEY('C', 'l', 0)] = 17,
+    [SYMBOL_KEY('A', 'r', 0)] = 18,
+    [SYMBOL_KEY('K', 0, 0)] = 19,
+    [SYMBOL_KEY('C', 'a', 0)] = 20,
+    [SYMBOL_KEY('S', 'c', 0)] = 21,
+    [SYMBOL_KEY('T', 'i', 0)] = 22,
+    [SYMBOL_KEY('V', 0, 0)] = 23,
+    [SYMBOL_KEY('C', 'r', 0)] = 24,
+    [SYMBOL_KEY('M', 'n', 0)] = 25,
+    [SYMBOL_KEY('F', 'e', 0)] = 26,
+    [SYMBOL_KEY('C', 'o', 0)] = 27,
+    [SYMBOL_KEY('N', 'i', 0)] = 28,
+    [SYMBOL_KEY('C', 'u', 0)] = 29,
+    [SYMBOL_KEY('Z', 'n', 0)] = 30,
+    [SYMBOL_KEY('G', 'a', 0)] = 31,
+    [SYMBOL_KEY('G', 'e', 0)] = 32,
+    [SYMBOL_KEY('A', 's', 0)] = 33,
+    [SYMBOL_KEY('S', 'e', 0)] = 34,
+    [SYMBOL_KEY('B', 'r', 0)] = 35,
+    [SYMBOL_KEY('K', 'r', 0)] = 36,
+    [SYMBOL_KEY('R', 'b', 0)] = 37,
+    [SYMBOL_KEY('S', 'r', 0)] = 38,
+    [SYMBOL_KEY('Y', 0, 0)] = 39,
+    [SYMBOL_KEY('Z', 'r', 0)] = 40,
+    [SYMBOL_KEY('N', 'b', 0)] = 41,
+    [SYMBOL_KEY('M', 'o', 0)] = 42,
+    [SYMBOL_KEY('T', 'c', 0)] = 43,
+    [SYMBOL_KEY('R', 'u', 0)] = 44,
+    [SYMBOL_KEY('R', 'h', 0)] = 45,
+    [SYMBOL_KEY('P', 'd', 0)] = 46,
+    [SYMBOL_KEY('A', 'g', 0)] = 47,
+    [SYMBOL_KEY('C', 'd', 0)] = 48,
+    [SYMBOL_KEY('I', 'n', 0)] = 49,
+    [SYMBOL_KEY('S', 'n', 0)] = 50,
+    [SYMBOL_KEY('S', 'b', 0)] = 51,
+    [SYMBOL_KEY('T', 'e', 0)] = 52,
+    [SYMBOL_KEY('I', 0, 0)] = 53,
+    [SYMBOL_KEY('X', 'e', 0)] = 54,
+    [SYMBOL_KEY('C', 's', 0)] = 55,
+    [SYMBOL_KEY('B', 'a', 0)] = 56,
+    [SYMBOL_KEY('L', 'a', 0)] = 57,
+    [SYMBOL_KEY('C', 'e', 0)] = 58,
+    [SYMBOL_KEY('P', 'r', 0)] = 59,
+    [SYMBOL_KEY('N', 'd', 0)] = 60,
+    [SYMBOL_KEY('P', 'm', 0)] = 61,
+    [SYMBOL_KEY('S', 'm', 0)] = 62,
+    [SYMBOL_KEY('E', 'u', 0)] = 63,
+    [SYMBOL_KEY('G', 'd', 0)] = 64,
+    [SYMBOL_KEY('T', 'b', 0)] = 65,
+    [SYMBOL_KEY('D', 'y', 0)] = 66,
+    [SYMBOL_KEY('H', 'o', 0)] = 67,
+    [SYMBOL_KEY('E', 'r', 0)] = 68,
+    [SYMBOL_KEY('T', 'm', 0)] = 69,
+    [SYMBOL_KEY('Y', 'b', 0)] = 70,
+    [SYMBOL_KEY('L', 'u', 0)] = 71,
+    [SYMBOL_KEY('H', 'f', 0)] = 72,
+    [SYMBOL_KEY('T', 'a', 0)] = 73,
+    [SYMBOL_KEY('W', 0, 0)] = 74,
+    [SYMBOL_KEY('R', 'e', 0)] = 75,
+    [SYMBOL_KEY('O', 's', 0)] = 76,
+    [SYMBOL_KEY('I', 'r', 0)] = 77,
+    [SYMBOL_KEY('P', 't', 0)] = 78,
+    [SYMBOL_KEY('A', 'u', 0)] = 79,
+    [SYMBOL_KEY('H', 'g', 0)] = 80,
+    [SYMBOL_KEY('T', 'l', 0)] = 81,
+    [SYMBOL_KEY('P', 'b', 0)] = 82,
+    [SYMBOL_KEY('B', 'i', 0)] = 83,
+    [SYMBOL_KEY('P', 'o', 0)] = 84,
+    [SYMBOL_KEY('A', 't', 0)] = 85,
+    [SYMBOL_KEY('R', 'n', 0)] = 86,
+    [SYMBOL_KEY('F', 'r', 0)] = 87,
+    [SYMBOL_KEY('R', 'a', 0)] = 88,
+    [SYMBOL_KEY('A', 'c', 0)] = 89,
+    [SYMBOL_KEY('T', 'h', 0)] = 90,
+    [SYMBOL_KEY('P', 'a', 0)] = 91,
+    [SYMBOL_KEY('U', 0, 0)] = 92,
+    [SYMBOL_KEY('N', 'p', 0)] = 93,
+    [SYMBOL_KEY('P', 'u', 0)] = 94,
+    [SYMBOL_KEY('A', 'm', 0)] = 95,
+    [SYMBOL_KEY('C', 'm', 0)] = 96,
+    [SYMBOL_KEY('B', 'k', 0)] = 97,
+    [SYMBOL_KEY('C', 'f', 0)] = 98,
+    [SYMBOL_KEY('E', 's', 0)] = 99,
+    [SYMBOL_KEY('F', 'm', 0)] = 100,
+    [SYMBOL_KEY('M', 'd', 0)] = 101,
+    [SYMBOL_KEY('N', 'o', 0)] = 102,
+    [SYMBOL_KEY('L', 'r', 0)] = 103,
+    [SYMBOL_KEY('R', 'f', 0)] = 104,
+    [SYMBOL_KEY('D', 'b', 0)] = 105,
+    [SYMBOL_KEY('S', 'g', 0)] = 106,
+    [SYMBOL_KEY('B', 'h', 0)] = 107,
+    [SYMBOL_KEY('H', 's', 0)] = 108,
+    [SYMBOL_KEY('M', 't', 0)] = 109,
+    [SYMBOL_KEY('D', 's', 0)] = 110,
+    [SYMBOL_KEY('R', 'g', 0)] = 111,
+    [SYMBOL_KEY('C', 'n', 0)] = 112,
+    [SYMBOL_KEY('U', 'u', 't')] = 113,
+    [SYMBOL_KEY('F', 'l', 0)] = 114,
+    [SYMBOL_KEY('U', 'u', 'p')] = 115,
+    [SYMBOL_KEY('L', 'v', 0)] = 116,
+    [SYMBOL_KEY('U', 'u', 's')] = 117,
+    [SYMBOL_KEY('U', 'u', 'o')] = 118};
 
 int createTable(PeriodicTable **table, int size)
 {
-    (*table) = (PeriodicTable *)malloc(sizeof(PeriodicTable));
+    (*table) = (PeriodicTable *)statsMalloc(sizeof(PeriodicTable));
     if ((*table) == NULL)
     {
-        printf("Could not allocate the periodic table!\n");
+        printError("Could not allocate the periodic table!\n");
         return EXIT_FAILURE;
     }
     (*table)->size = size;
-    (*table)->array = (Molecule *)malloc(sizeof(Molecule) * size);
+    (*table)->index = NULL;
+    (*table)->order = NULL;
+    (*table)->orderSize = 0;
+    (*table)->map = NULL;
+    (*table)->mapSize = 0;
+    (*table)->masses = NULL;
+    (*table)->array = (Molecule *)statsMalloc(sizeof(Molecule) * (size > 0 ? size : 1));
     if ((*table)->array == NULL)
     {
-        printf("Could not allocate the periodic table array!\n");
+        printError("Could not allocate the periodic table array!\n");
         free(*table); // Free table if array allocation fails
         return EXIT_FAILURE;
     }
     return EXIT_SUCCESS;
 }
 
-int createMolecule(PeriodicTable *table, char *buffer, int number, int index)
+int createMolecule(PeriodicTable *table, char *buffer, int number, double averageMass, double exactMass, int index)
 {
 
     if (table == NULL)
     {
-        printf("Tabel is NULL!\n");
+        printError("Tabel is NULL!\n");
         return EXIT_FAILURE;
     }
 
-    Molecule *newMolecule = NULL;
-    newMolecule = (Molecule *)malloc(sizeof(Molecule));
-    if (newMolecule == NULL)
+    if (strlen(buffer) >= MOLECULE_NAME_SIZE)
     {
-        printf("Could not allocate a new molecule!\n");
-        free(newMolecule);
+        printError("The molecule name %s is too long!\n", buffer);
         return EXIT_FAILURE;
     }
 
-    newMolecule->periodicNum = number;
-    newMolecule->name = (char *)malloc(strlen(buffer) + 1);
-    if (newMolecule->name == NULL)
+    table->array[index].periodicNum = number;
+    strcpy(table->array[index].name, buffer);
+    table->array[index].averageMass = averageMass;
+    table->array[index].exactMass = exactMass;
+    return EXIT_SUCCESS;
+}
+
+int compareMolecules(const void *first, const void *second)
+{
+    const Molecule *a = *(const Molecule *const *)first;
+    const Molecule *b = *(const Molecule *const *)second;
+    if (a->periodicNum != b->periodicNum)
+    {
+        return a->periodicNum < b->periodicNum ? -1 : 1;
+    }
+    /* the place in the array breaks ties, which keeps the sort stable */
+    return a < b ? -1 : (a > b ? 1 : 0);
+}
+
+int sortTable(PeriodicTable *table)
+{
+    int sorted = 1;
+    for (int i = 1; i < table->size && sorted; i++)
     {
-        printf("Could not alocate the new molecule's name!\n");
-        return EXIT_FAILURE;
+        sorted = table->array[i - 1].periodicNum <= table->array[i].periodicNum;
+    }
+    if (sorted)
+    {
+        return EXIT_SUCCESS;
     }
 
-    strcpy((newMolecule->name), buffer);
-    table->array[index] = *newMolecule;
-    free(newMolecule);
+    Molecule **order = (Molecule **)statsMalloc(sizeof(Molecule *) * table->size);
+    Molecule *array = (Molecule *)statsMalloc(sizeof(Molecule) * table->size);
+    if (order == NULL || array == NULL)
+    {
+        printError("Could not allocate memory to sort the periodic table!\n");
+        free(order);
+        free(array);
+        return EXIT_FAILURE;
+    }
+    for (int i = 0; i < table->size; i++)
+    {
+        order[i] = &table->array[i];
+    }
+    qsort(order, table->size, sizeof(Molecule *), compareMolecules);
+    for (int i = 0; i < table->size; i++)
+    {
+        array[i] = *order[i];
+    }
+    free(order);
+    free(table->array);
+    table->array = array;
     return EXIT_SUCCESS;
 }
 
-void insertionSort(PeriodicTable *table)
+int parseTableLine(const char *line, size_t length, char *name, int *number, double *averageMass, double *exactMass)
 {
-    for (int i = 1; i < table->size; i++)
+    size_t i = 0;
+    while (i < length && isspace((unsigned char)line[i]))
     {
-        int value = table->array[i].periodicNum;
-        char name[1024];
-        strcpy(name, table->array[i].name);
+        i++;
+    }
+    if (i == length)
+    {
+        return 0;
+    }
 
-        int j = i - 1;
-        while (j >= 0 && table->array[j].periodicNum > value)
+    size_t size = 0;
+    while (i < length && !isspace((unsigned char)line[i]))
+    {
+        if (size == MOLECULE_NAME_SIZE - 1)
         {
-            table->array[j + 1].periodicNum = table->array[j].periodicNum;
-            strcpy(table->array[j + 1].name, table->array[j].name);
-            j--;
+            return -1;
         }
+        name[size++] = line[i++];
+    }
+    name[size] = '\0';
 
-        table->array[j + 1].periodicNum = value;
-        strcpy(table->array[j + 1].name, name);
+    while (i < length && isspace((unsigned char)line[i]))
+    {
+        i++;
+    }
+    int negative = i < length && line[i] == '-';
+    if (negative || (i < length && line[i] == '+'))
+    {
+        i++;
+    }
+    if (i == length || !isdigit((unsigned char)line[i]))
+    {
+        return -1;
+    }
+    long value = 0;
+    while (i < length && isdigit((unsigned char)line[i]))
+    {
+        if (value > INT_MAX / 10)
+        {
+            return -1;
+        }
+        value = value * 10 + (line[i++] - '0');
     }
+    if (value > INT_MAX)
+    {
+        return -1;
+    }
+    *number = (int)(negative ? -value : value);
+
+    /* the two mass columns are optional, strtod needs them null terminated */
+    char masses[MASS_COLUMNS_SIZE];
+    if (length - i >= sizeof(masses))
+    {
+        return -1;
+    }
+    memcpy(masses, line + i, length - i);
+    masses[length - i] = '\0';
+    char *end = masses;
+    while (isspace((unsigned char)*end))
+    {
+        end++;
+    }
+    *averageMass = 0.0;
+    *exactMass = 0.0;
+    if (*end != '\0')
+    {
+        char *start = end;
+        *averageMass = strtod(start, &end);
+        if (end == start)
+        {
+            return -1;
+        }
+        start = end;
+        *exactMass = strtod(start, &end);
+        if (end == start)
+        {
+            return -1;
+        }
+        while (isspace((unsigned char)*end))
+        {
+            end++;
+        }
+    }
+    return *end == '\0' ? 1 : -1;
 }
 
 PeriodicTable *getTable(char *fileName)
 {
-    char input[1024];
-    strcpy(input, fileName);
+    if (strcmp(fileName, DEFAULT_TABLE) == 0)
+    {
+        return getDefaultTable();
+    }
 
-    FILE *fp;
-    fp = fopen(input, "r");
-    if (fp == NULL)
+    LineReader *reader = NULL;
+    if (openReader(&reader, fileName) == EXIT_FAILURE)
+    {
+        return NULL;
+    }
+    char *line = NULL;
+    size_t length = 0;
+    int read = nextLine(reader, &line, &length);
+    if (read == 1 && length >= sizeof(TABLE_MAGIC) && memcmp(line, TABLE_MAGIC, sizeof(TABLE_MAGIC)) == 0)
+    {
+        closeReader(reader);
+        return mapTable(fileName);
+    }
+    /* the magic without its version digit marks a table of another version */
+    if (read == 1 && length >= sizeof(TABLE_MAGIC) - 2 && memcmp(line, TABLE_MAGIC, sizeof(TABLE_MAGIC) - 2) == 0)
     {
-        printf("Could not open %s!\n", fileName);
+        printError("The compiled table %s has an older format, compile it again!\n", fileName);
+        closeReader(reader);
         return NULL;
     }
-    char buffer[1024];
-    int size = 0;
-    while (!feof(fp))
+
+    PeriodicTable *table;
+    int capacity = 128;
+    if (createTable(&table, capacity) == EXIT_FAILURE)
     {
-        if (fgets(buffer, sizeof(buffer), fp) == NULL)
+        closeReader(reader);
+        return NULL;
+    }
+    table->size = 0;
+
+    char name[MOLECULE_NAME_SIZE];
+    int number = 0;
+    double averageMass = 0.0;
+    double exactMass = 0.0;
+    int lineNumber = 0;
+    for (; read == 1; read = nextLine(reader, &line, &length))
+    {
+        lineNumber++;
+        int found = parseTableLine(line, length, name, &number, &averageMass, &exactMass);
+        if (found == 0)
         {
+            continue;
+        }
+        if (found < 0)
+        {
+            printError("Invalid periodic table entry in line %d of %s!\n", lineNumber, fileName);
             break;
         }
-        size++;
+        if (table->size == capacity)
+        {
+            Molecule *array = (Molecule *)statsRealloc(table->array, sizeof(Molecule) * capacity * 2);
+            if (array == NULL)
+            {
+                printError("Could not grow the periodic table array!\n");
+                break;
+            }
+            table->array = array;
+            capacity *= 2;
+        }
+        createMolecule(table, name, number, averageMass, exactMass, table->size);
+        table->size++;
     }
-    fclose(fp);
+    closeReader(reader);
 
-    PeriodicTable *table;
-    if (createTable(&table, size) == EXIT_FAILURE)
+    if (read != 0 || sortTable(table) == EXIT_FAILURE || buildIndex(table) == EXIT_FAILURE || buildMasses(table) == EXIT_FAILURE)
     {
-        printf("Could not allocate the table!");
+        freeTable(table);
         return NULL;
     }
-    FILE *fp2;
-    fp2 = fopen(input, "r");
-    if (fp2 == NULL)
+    return table;
+}
+
+PeriodicTable *mapTable(char *fileName)
+{
+    int fd = open(fileName, O_RDONLY);
+    if (fd < 0)
     {
-        printf("Could not open file!");
+        printError("Could not open %s!\n", fileName);
         return NULL;
     }
-    int number = 0;
-    int i = 0;
-    while (!feof(fp2))
+    struct stat info;
+    void *map = MAP_FAILED;
+    if (fstat(fd, &info) == 0 && (size_t)info.st_size >= sizeof(TableHeader))
+    {
+        map = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    if (map == MAP_FAILED)
+    {
+        printError("Could not map the compiled table %s!\n", fileName);
+        return NULL;
+    }
+
+    const TableHeader *header = (const TableHeader *)map;
+    size_t arraySize = sizeof(Molecule) * (size_t)(header->size > 0 ? header->size : 0);
+    int valid = header->size > 0 && header->orderSize >= 0 && header->orderSize <= header->size &&
+                header->fileSize == info.st_size &&
+                header->indexOffset == (int)(sizeof(TableHeader) + arraySize) &&
+                header->orderOffset >= header->indexOffset + (int)(sizeof(short) * SYMBOL_KEYS) &&
+                header->orderOffset % sizeof(int) == 0 &&
+                (size_t)header->orderOffset + sizeof(int) * header->orderSize <= (size_t)info.st_size;
+
+    PeriodicTable *table = NULL;
+    if (valid && (table = (PeriodicTable *)statsMalloc(sizeof(PeriodicTable))) == NULL)
     {
-        int f1 = fscanf(fp2, "%s", buffer);
-        int f2 = fscanf(fp2, "%d", &number);
-        if (f1 == EOF || f2 == EOF)
+        printError("Could not allocate the periodic table!\n");
+    }
+    if (table != NULL)
+    {
+        table->map = map;
+        table->mapSize = info.st_size;
+        table->size = header->size;
+        table->orderSize = header->orderSize;
+        table->array = (Molecule *)((char *)map + sizeof(TableHeader));
+        table->index = (short *)((char *)map + header->indexOffset);
+        table->order = (int *)((char *)map + header->orderOffset);
+
+        /* the arrays are used without checks later, so a damaged file is rejected here */
+        for (int i = 0; i < table->size && valid; i++)
         {
-            break;
+            valid = memchr(table->array[i].name, '\0', MOLECULE_NAME_SIZE) != NULL;
         }
-        if (f1 == 0 || f2 == 0)
+        for (int key = 0; key < SYMBOL_KEYS && valid; key++)
         {
-            fclose(fp2);
-            freeCurrTable(table, i);
-            return NULL;
+            valid = table->index[key] >= 0 && table->index[key] <= table->size;
         }
-        createMolecule(table, buffer, number, i);
-        i++;
+        for (int i = 0; i < table->orderSize && valid; i++)
+        {
+            valid = table->order[i] >= 0 && table->order[i] < table->size;
+        }
+        table->masses = NULL;
+        if (!valid || buildMasses(table) == EXIT_FAILURE)
+        {
+            free(table);
+            table = NULL;
+        }
+    }
+    if (table == NULL)
+    {
+        if (!valid)
+        {
+            printError("The compiled table %s is damaged!\n", fileName);
+        }
+        munmap(map, info.st_size);
     }
-    fclose(fp2);
+    return table;
+}
 
-    insertionSort(table);
+int saveTable(PeriodicTable *table, char *fileName)
+{
+    TableHeader header;
+    memset(&header, 0, sizeof(TableHeader));
+    memcpy(header.magic, TABLE_MAGIC, sizeof(TABLE_MAGIC));
+    size_t indexOffset = sizeof(TableHeader) + sizeof(Molecule) * table->size;
+    size_t orderOffset = indexOffset + sizeof(short) * SYMBOL_KEYS;
+    orderOffset = (orderOffset + sizeof(int) - 1) / sizeof(int) * sizeof(int);
+    size_t fileSize = orderOffset + sizeof(int) * table->orderSize;
+    if (fileSize > INT_MAX)
+    {
+        printError("The periodic table is too large to compile!\n");
+        return EXIT_FAILURE;
+    }
+    header.size = table->size;
+    header.orderSize = table->orderSize;
+    header.indexOffset = (int)indexOffset;
+    header.orderOffset = (int)orderOffset;
+    header.fileSize = (int)fileSize;
 
+    FILE *fp = fopen(fileName, "wb");
+    if (fp == NULL)
+    {
+        printError("Could not open %s!\n", fileName);
+        return EXIT_FAILURE;
+    }
+    /* names are written whole, so the unused bytes after them must be zero */
+    Molecule *array = (Molecule *)statsCalloc(table->size, sizeof(Molecule));
+    int status = array == NULL ? EXIT_FAILURE : EXIT_SUCCESS;
+    for (int i = 0; i < table->size && array != NULL; i++)
+    {
+        array[i].periodicNum = table->array[i].periodicNum;
+        strcpy(array[i].name, table->array[i].name);
+        array[i].averageMass = table->array[i].averageMass;
+        array[i].exactMass = table->array[i].exactMass;
+    }
+    char padding[sizeof(int)] = {0};
+    if (status == EXIT_FAILURE ||
+        fwrite(&header, sizeof(TableHeader), 1, fp) != 1 ||
+        fwrite(array, sizeof(Molecule), table->size, fp) != (size_t)table->size ||
+        fwrite(table->index, sizeof(short), SYMBOL_KEYS, fp) != SYMBOL_KEYS ||
+        fwrite(padding, 1, orderOffset - indexOffset - sizeof(short) * SYMBOL_KEYS, fp) != orderOffset - indexOffset - sizeof(short) * SYMBOL_KEYS ||
+        fwrite(table->order, sizeof(int), table->orderSize, fp) != (size_t)table->orderSize)
+    {
+        printError("Could not write the compiled table to %s!\n", fileName);
+        status = EXIT_FAILURE;
+    }
+    free(array);
+    if (fclose(fp) != 0)
+    {
+        status = EXIT_FAILURE;
+    }
+    if (status == EXIT_FAILURE)
+    {
+        remove(fileName);
+    }
+    return status;
+}
+
+PeriodicTable *getDefaultTable(void)
+{
+    PeriodicTable *table;
+    if (createTable(&table, DEFAULT_SIZE) == EXIT_FAILURE)
+    {
+        return NULL;
+    }
+    for (int i = 0; i < DEFAULT_SIZE; i++)
+    {
+        if (createMolecule(table, (char *)defaultNames[i], defaultNumbers[i], defaultAverageMasses[i], defaultExactMasses[i], i) == EXIT_FAILURE)
+        {
+            freeTable(table);
+            return NULL;
+        }
+    }
+    table->index = (short *)statsMalloc(sizeof(defaultIndex));
+    if (table->index == NULL)
+    {
+        printError("Could not allocate the symbol index!\n");
+        freeTable(table);
+        return NULL;
+    }
+    memcpy(table->index, defaultIndex, sizeof(defaultIndex));
+    if (buildOrder(table) == EXIT_FAILURE || buildMasses(table) == EXIT_FAILURE)
+    {
+        freeTable(table);
+        return NULL;
+    }
     return table;
 }
 
-void freeTable(PeriodicTable *table)
+int buildIndex(PeriodicTable *table)
+{
+    table->index = (short *)statsCalloc(SYMBOL_KEYS, sizeof(short));
+    if (table->index == NULL)
+    {
+        printError("Could not allocate the symbol index!\n");
+        return EXIT_FAILURE;
+    }
+    for (int i = table->size - 1; i >= 0; i--)
+    {
+        int key = symbolKey(table->array[i].name, strlen(table->array[i].name));
+        if (key >= 0)
+        {
+            table->index[key] = (short)(i + 1);
+        }
+    }
+    return buildOrder(table);
+}
+
+int buildOrder(PeriodicTable *table)
 {
+    table->order = (int *)statsMalloc(sizeof(int) * (table->size + 1));
+    if (table->order == NULL)
+    {
+        printError("Could not allocate the alphabetical order!\n");
+        return EXIT_FAILURE;
+    }
+    table->orderSize = 0;
+    for (int key = 0; key < SYMBOL_KEYS; key++)
+    {
+        if (table->index[key] != 0)
+        {
+            table->order[table->orderSize++] = table->index[key] - 1;
+        }
+    }
+    return EXIT_SUCCESS;
+}
+
+int buildMasses(PeriodicTable *table)
+{
+    table->masses = (double *)statsMalloc(sizeof(double) * 2 * table->size);
+    if (table->masses == NULL)
+    {
+        printError("Could not allocate the mass vectors!\n");
+        return EXIT_FAILURE;
+    }
     for (int i = 0; i < table->size; i++)
     {
-        free(table->array[i].name);
+        table->masses[i] = table->array[i].averageMass;
+        table->masses[table->size + i] = table->array[i].exactMass;
     }
-    free(table->array);
-    free(table);
+    return EXIT_SUCCESS;
 }
 
-void freeCurrTable(PeriodicTable *table, int currentSize)
+int hasMasses(PeriodicTable *table)
 {
-    for (int i = 0; i < currentSize; i++)
+    if (table->masses == NULL)
     {
-        free(table->array[i].name);
+        return 0;
+    }
+    for (int i = 0; i < table->size; i++)
+    {
+        if (table->array[i].averageMass != 0.0 || table->array[i].exactMass != 0.0)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int symbolKey(const char *symbol, int length)
+{
+    if (length < 1 || length > 3 || symbol[0] < 'A' || symbol[0] > 'Z')
+    {
+        return -1;
+    }
+    int key = symbol[0] - 'A';
+    for (int i = 1; i < 3; i++)
+    {
+        int letter = 0;
+        if (i < length)
+        {
+            if (symbol[i] < 'a' || symbol[i] > 'z')
+            {
+                return -1;
+            }
+            letter = symbol[i] - 'a' + 1;
+        }
+        key = key * 27 + letter;
+    }
+    return key;
+}
+
+void freeTable(PeriodicTable *table)
+{
+    free(table->masses);
+    if (table->map != NULL)
+    {
+        munmap(table->map, table->mapSize);
+        free(table);
+        return;
     }
     free(table->array);
+    free(table->index);
+    free(table->order);
     free(table);
 }
 
+void freeCurrTable(PeriodicTable *table, int currentSize)
+{
+    /* names are kept inline, so nothing is allocated per molecule */
+    (void)currentSize;
+    freeTable(table);
+}
+
 int isMolecule(char *molecule, PeriodicTable *table)
 {
-    if (molecule == NULL || table == NULL)
+    if (findMoleculeIndex(molecule, table) < 0)
     {
         return EXIT_FAILURE;
     }
-    for (int i = 0; i < table->size; i++)
+    return EXIT_SUCCESS;
+}
+
+int findMoleculeIndex(char *molecule, PeriodicTable *table)
+{
+    if (molecule == NULL || table == NULL)
     {
-        if (strcmp(table->array[i].name, molecule) == 0)
-        {
-            return EXIT_SUCCESS;
-        }
+        return -1;
+    }
+    return findSymbolIndex(molecule, strlen(molecule), table);
+}
+
+int findSymbolIndex(const char *symbol, int length, PeriodicTable *table)
+{
+    int key = symbolKey(symbol, length);
+    if (key < 0)
+    {
+        return -1;
     }
-    return EXIT_FAILURE;
+    return table->index[key] - 1;
 }
 
 #ifdef DEBUG
@@ -4,6 +4,13 @@
  *
  * This file contains the functions prototypes for loading, managing, and sorting the elements of a periodic table from a file.
  *
+ * A table is read from a text file with a name and an atomic number per line,
+ * optionally followed by the average and the monoisotopic mass, or
+ * mapped in place from a compiled binary file written by saveTable. The binary
+ * file holds a TableHeader followed by the molecule array, the symbol index and
+ * the alphabetical order exactly as they are kept in memory, so it is only
+ * valid on machines with the same byte order.
+ *
  * @author Nicolas Constantinou
  * @date 23/10/2024
  */
@@ -14,24 +21,97 @@
 #include <string.h>
 #include <stdio.h>
 
+#include "Library.h"
+
+/**
+ * @brief Name of the periodic table argument that selects the embedded standard table.
+ */
+#define DEFAULT_TABLE "builtin"
+
+/**
+ * @brief Number of slots of the symbol lookup index.
+ *
+ * A symbol is an uppercase letter followed by up to two lowercase letters, so
+ * every symbol maps to a unique slot in [0, 26 * 27 * 27).
+ */
+#define SYMBOL_KEYS (26 * 27 * 27)
+
+/**
+ * @brief Slot of the symbol lookup index for the letters a, b and c.
+ *
+ * Missing letters are given as 0. The macro is a constant expression, so it can
+ * be used in static initializers.
+ */
+#define SYMBOL_KEY(a, b, c) ((((a) - 'A') * 27 + ((b) ? (b) - 'a' + 1 : 0)) * 27 + ((c) ? (c) - 'a' + 1 : 0))
+
+/**
+ * @brief Bytes kept for the name of a molecule, with its null terminator.
+ */
+#define MOLECULE_NAME_SIZE 12
+
+/**
+ * @brief First bytes of a compiled periodic table file.
+ */
+#define TABLE_MAGIC "PTABLE2"
+
+/**
+ * @brief Largest number of bytes of the mass columns of a table line.
+ */
+#define MASS_COLUMNS_SIZE 128
+
 /**
  * @struct Molecule
- * @brief Structure to represent a molecule and its proton number.
+ * @brief Structure to represent a molecule, its proton number and its masses.
+ *
+ * The name is kept inline, so the array has no pointers and can be mapped from a file.
+ * The masses are in unified atomic mass units, 0 when the table does not give them.
  */
 typedef struct molecule
 {
     int periodicNum;
-    char *name;
+    char name[MOLECULE_NAME_SIZE];
+    double averageMass;
+    double exactMass;
 } Molecule;
 
+/**
+ * @struct TableHeader
+ * @brief Header of a compiled periodic table file.
+ *
+ * The offsets are counted in bytes from the start of the file.
+ */
+typedef struct tableHeader
+{
+    char magic[8];
+    int size;
+    int orderSize;
+    int indexOffset;
+    int orderOffset;
+    int fileSize;
+    int reserved;
+} TableHeader;
+
 /**
  * @struct PeriodicTable
  * @brief Structure representing a periodic table with a list of molecules.
+ *
+ * index maps SYMBOL_KEY of every name to its position in array plus one,
+ * 0 marks a symbol that is not in the table. order lists the positions of the
+ * orderSize indexed molecules in alphabetical order of their names. masses
+ * holds the average masses of the molecules followed by their exact masses,
+ * as vectors that line up with the element count arrays. map is the mapped
+ * file of a compiled table, which then holds array, index and order.
  */
 typedef struct periodicTable
 {
     Molecule *array;
+    short *index;
+    int *order;
+    int orderSize;
     int size;
+    double *masses;
+    void *map;
+    size_t mapSize;
 } PeriodicTable;
 
 /**
@@ -49,46 +129,151 @@ int createTable(PeriodicTable **table, int size);
 /**
  * @brief Creates a new molecule and adds it to the periodic table.
  *
- * This function allocates memory and initializes a new Molecule and inserts it into the periodic table at a specified index.
+ * This function initializes a new Molecule in the periodic table at a specified index.
+ * Names longer than MOLECULE_NAME_SIZE - 1 letters are rejected.
  *
  * @param table Pointer of PeriodicTable.
  * @param buffer The name of the molecule to be added.
  * @param number The atomic number of the molecule to be added.
+ * @param averageMass The standard atomic weight of the molecule.
+ * @param exactMass The monoisotopic mass of the molecule.
  * @param index The index in the array where the molecule will be stored.
  * @return int Returns EXIT_SUCCESS on success or EXIT_FAILURE on failure.
  */
-int createMolecule(PeriodicTable *table, char *buffer, int number, int index);
+int createMolecule(PeriodicTable *table, char *buffer, int number, double averageMass, double exactMass, int index);
 
 /**
  * @brief Loads a periodic table from a file.
  *
- * This function reads a file containing the names and atomic numbers of the elements,
- * creates a PeriodicTable, and fills it with the elements read from the file, then sorts it using insertion sort.
+ * A compiled table is mapped with mapTable. Otherwise this function reads the
+ * names and atomic numbers of the elements in one pass, creates a PeriodicTable,
+ * and fills it with the elements read from the file, then sorts it with sortTable.
  *
  * @param fileName The name of the file containing the periodic table data.
  * @return PeriodicTable* Pointer of PeriodicTable or NULL on failure.
  */
-PeriodicTable *getTable(char *fileName);
+FORMULA_API PeriodicTable *getTable(char *fileName);
+
+/**
+ * @brief Parses one line of a periodic table text file.
+ *
+ * @param line The line, without its new line.
+ * @param length The length of the line.
+ * @param name Buffer of MOLECULE_NAME_SIZE bytes that receives the name.
+ * @param number Pointer that receives the atomic number.
+ * @param averageMass Pointer that receives the average mass, 0 without the mass columns.
+ * @param exactMass Pointer that receives the monoisotopic mass, 0 without the mass columns.
+ * @return int 1 if a molecule was read, 0 for an empty line, -1 for an invalid line.
+ */
+int parseTableLine(const char *line, size_t length, char *name, int *number, double *averageMass, double *exactMass);
+
+/**
+ * @brief Maps a compiled periodic table file and uses it in place.
+ *
+ * The header and the bounds of the index and order are checked, nothing is parsed or sorted.
+ *
+ * @param fileName The name of the compiled file.
+ * @return PeriodicTable* Pointer of PeriodicTable or NULL on failure.
+ */
+FORMULA_API PeriodicTable *mapTable(char *fileName);
+
+/**
+ * @brief Writes a periodic table as a compiled file that mapTable can load.
+ *
+ * @param table Pointer of PeriodicTable with its index built.
+ * @param fileName The name of the compiled file.
+ * @return int Returns EXIT_SUCCESS on success or EXIT_FAILURE on failure.
+ */
+FORMULA_API int saveTable(PeriodicTable *table, char *fileName);
+
+/**
+ * @brief Creates the standard periodic table embedded in the program.
+ *
+ * The names, atomic numbers and the symbol index are compiled in,
+ * so no file is read.
+ *
+ * @return PeriodicTable* Pointer of PeriodicTable or NULL on failure.
+ */
+FORMULA_API PeriodicTable *getDefaultTable(void);
+
+/**
+ * @brief Builds the symbol lookup index of a periodic table.
+ *
+ * Names that are not an uppercase letter followed by up to two lowercase
+ * letters cannot be indexed and are skipped. When a name appears twice,
+ * the first one is kept. The alphabetical order is built as well.
+ *
+ * @param table Pointer of PeriodicTable.
+ * @return int Returns EXIT_SUCCESS on success or EXIT_FAILURE on failure.
+ */
+int buildIndex(PeriodicTable *table);
+
+/**
+ * @brief Builds the alphabetical order of a periodic table from its symbol index.
+ *
+ * Slots of the index are in alphabetical order of the symbols, so one scan of
+ * the index gives the order.
+ *
+ * @param table Pointer of PeriodicTable with its index built.
+ * @return int Returns EXIT_SUCCESS on success or EXIT_FAILURE on failure.
+ */
+int buildOrder(PeriodicTable *table);
+
+/**
+ * @brief Builds the mass vectors of a periodic table from its molecules.
+ *
+ * @param table Pointer of PeriodicTable.
+ * @return int Returns EXIT_SUCCESS on success or EXIT_FAILURE on failure.
+ */
+int buildMasses(PeriodicTable *table);
+
+/**
+ * @brief Tells if a periodic table gives the masses of its elements.
+ *
+ * @param table Pointer to the periodic table.
+ * @return int 1 if an element has a mass and the mass vectors are built, 0 otherwise.
+ */
+int hasMasses(PeriodicTable *table);
+
+/**
+ * @brief Computes the slot of a symbol in the lookup index.
+ *
+ * @param symbol The first letter of the symbol.
+ * @param length The number of letters of the symbol.
+ * @return int The slot of the symbol or -1 if it is not a valid symbol.
+ */
+int symbolKey(const char *symbol, int length);
 
 /**
- * @brief Sorts the periodic table using insertion sort on atomic numbers.
+ * @brief Sorts the periodic table on atomic numbers.
  *
  * This function sorts the elements in the periodic table array in ascending
- * based on their atomic numbers.
+ * order of their atomic numbers. Elements with the same number keep their order.
+ * A table that is already sorted, as the usual files are, is only checked.
  *
  * @param table Pointer of PeriodicTable.
+ * @return int Returns EXIT_SUCCESS on success or EXIT_FAILURE on failure.
+ */
+int sortTable(PeriodicTable *table);
+
+/**
+ * @brief Compares two molecules by atomic number, then by their place in the array.
+ *
+ * @param first Pointer to the first Molecule pointer.
+ * @param second Pointer to the second Molecule pointer.
+ * @return int Negative, zero or positive as for qsort.
  */
-void insertionSort(PeriodicTable *table);
+int compareMolecules(const void *first, const void *second);
 
 /**
  * @brief Frees the memory allocated for the periodic table.
  *
- * This function frees all memory of the periodic table,
- * including the names of the molecules and lastly the table.
+ * This function frees all memory of the periodic table, or unmaps
+ * its compiled file, and lastly the table.
  *
  * @param table Pointer of PeriodicTable to be freed.
  */
-void freeTable(PeriodicTable *table);
+FORMULA_API void freeTable(PeriodicTable *table);
 
 /**
  * @brief Frees memory associated with a partially filled periodic table.
@@ -111,4 +296,28 @@ void freeCurrTable(PeriodicTable *table, int currentSize);
  */
 int isMolecule(char *molecule, PeriodicTable *table);
 
+/**
+ * @brief Finds the position of a molecule in the periodic table.
+ *
+ * Searches for a molecule name in the table and returns its index in the array,
+ * which is also its position in the element count arrays.
+ *
+ * @param molecule The name of the molecule to search for.
+ * @param table The periodic table to search.
+ * @return int The index of the molecule or -1 if not found.
+ */
+int findMoleculeIndex(char *molecule, PeriodicTable *table);
+
+/**
+ * @brief Finds the position of a symbol that is not null terminated.
+ *
+ * Same as findMoleculeIndex, for symbols read in place from a formula.
+ *
+ * @param symbol The first letter of the symbol.
+ * @param length The number of letters of the symbol.
+ * @param table The periodic table to search.
+ * @return int The index of the molecule or -1 if not found.
+ */
+FORMULA_API int findSymbolIndex(const char *symbol, int length, PeriodicTable *table);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,238 @@
+/**
+ * @file testLibrary.c
+ *
+ * @brief Test of the library parsing formulas from many threads at once.
+ *
+ * Every thread creates a parser of its own on one shared periodic table and
+ * parses the same formulas a number of times with parseCounts and
+ * parseExpansion, checking every result against the expected one. Any
+ * difference, such as one thread seeing the work space of another, fails
+ * the test.
+ *
+ * usage: testLibrary [periodicTable]
+ *
+ * The program is linked with libformula.a, see the test target of the makefile.
+ * Without a periodic table file the table compiled into the library is used.
+ *
+ * @author Nicolas Constantinou
+ * @date 23/10/2024
+ */
+#include <pthread.h>
+#include "FormulaLibrary.h"
+
+#define TEST_THREADS 8
+#define TEST_ROUNDS 2000
+#define TEST_ELEMENTS 4
+
+/**
+ * @struct TestCase
+ *
+ * @brief A formula with the result the library must give for it.
+ *
+ * The counts list the atoms of up to TEST_ELEMENTS elements, every other
+ * element must have none. expansion is only checked with FORMULA_OK.
+ */
+typedef struct testCase
+{
+    const char *formula;
+    int status;
+    const char *expansion;
+    const char *symbols[TEST_ELEMENTS];
+    long long counts[TEST_ELEMENTS];
+} TestCase;
+
+/**
+ * @brief The formulas of the test.
+ */
+static const TestCase cases[] = {
+    {"H2O", FORMULA_OK, "HHO", {"H", "O"}, {2, 1}},
+    {"Mg(OH)2", FORMULA_OK, "MgOHOH", {"Mg", "O", "H"}, {1, 2, 2}},
+    {"Ga(C2H3O2)3", FORMULA_OK, "GaCCHHHOOCCHHHOOCCHHHOO", {"Ga", "C", "H", "O"}, {1, 6, 9, 6}},
+    {"((CH)2O)3", FORMULA_OK, "CHCHOCHCHOCHCHO", {"C", "H", "O"}, {6, 6, 3}},
+    {"(((H)10)10)10", FORMULA_OK, NULL, {"H"}, {1000}},
+    {"Fe2(SO4)3", FORMULA_OK, "FeFeSOOOOSOOOOSOOOO", {"Fe", "S", "O"}, {2, 3, 12}},
+    {"Mg(OH2", FORMULA_UNBALANCED, NULL, {NULL}, {0}},
+    {"H2O)", FORMULA_UNBALANCED, NULL, {NULL}, {0}},
+    {"Xy2", FORMULA_INVALID, NULL, {NULL}, {0}},
+    {"(H)2147483647 2147483647", FORMULA_INVALID, NULL, {NULL}, {0}},
+    {"H2147483648", FORMULA_INVALID, NULL, {NULL}, {0}},
+    {"((H2147483647)2147483647)2147483647", FORMULA_TOO_LARGE, NULL, {NULL}, {0}},
+};
+
+#define TEST_CASES ((int)(sizeof(cases) / sizeof(cases[0])))
+
+/**
+ * @struct TestThread
+ *
+ * @brief The shared table of a test thread and the number of wrong results it found.
+ */
+typedef struct testThread
+{
+    pthread_t thread;
+    int index;
+    PeriodicTable *table;
+    long failures;
+} TestThread;
+
+/**
+ * @brief Checks the results of one formula.
+ *
+ * @param parser Pointer to the parser of the thread.
+ * @param test Pointer to the formula and its expected result.
+ * @param counts Array of table->size counts used as work space.
+ * @param buffer Buffer of the expansion.
+ * @param size The size of the buffer.
+ * @return int EXIT_SUCCESS if every result is right, EXIT_FAILURE otherwise.
+ */
+int checkCase(FormulaParser *parser, const TestCase *test, long long *counts, char *buffer, size_t size)
+{
+    PeriodicTable *table = parser->table;
+    size_t length = strlen(test->formula);
+    if (parseCounts(parser, test->formula, length, counts) != test->status)
+    {
+        return EXIT_FAILURE;
+    }
+    size_t needed = 0;
+    int status = parseExpansion(parser, test->formula, length, buffer, size, &needed);
+    if (status != test->status)
+    {
+        return EXIT_FAILURE;
+    }
+    if (test->status != FORMULA_OK)
+    {
+        return EXIT_SUCCESS;
+    }
+    if (test->expansion != NULL && (strcmp(buffer, test->expansion) != 0 || needed != strlen(test->expansion) + 1))
+    {
+        return EXIT_FAILURE;
+    }
+
+    long long listed = 0;
+    for (int i = 0; i < TEST_ELEMENTS && test->symbols[i] != NULL; i++)
+    {
+        int index = findSymbolIndex(test->symbols[i], (int)strlen(test->symbols[i]), table);
+        if (index < 0 || counts[index] != test->counts[i])
+        {
+            return EXIT_FAILURE;
+        }
+        listed += test->counts[i];
+    }
+    long long total = 0;
+    for (int i = 0; i < table->size; i++)
+    {
+        total += counts[i];
+    }
+    if (total != listed)
+    {
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Parses every formula TEST_ROUNDS times with a parser of its own.
+ *
+ * @param arg Pointer to the TestThread, passed as void* to be a thread function.
+ * @return void* Always NULL.
+ */
+void *runTest(void *arg)
+{
+    TestThread *test = (TestThread *)arg;
+    FormulaParser *parser = NULL;
+    long long *counts = (long long *)malloc(sizeof(long long) * test->table->size);
+    char buffer[1024];
+    if (counts == NULL || initFormulaParser(&parser, test->table) != FORMULA_OK)
+    {
+        free(counts);
+        test->failures = -1;
+        return NULL;
+    }
+    for (int round = 0; round < TEST_ROUNDS; round++)
+    {
+        /* every thread starts at another formula, so different formulas run at the same time */
+        for (int i = 0; i < TEST_CASES; i++)
+        {
+            const TestCase *current = &cases[(i + round + test->index) % TEST_CASES];
+            if (checkCase(parser, current, counts, buffer, sizeof(buffer)) == EXIT_FAILURE)
+            {
+                test->failures++;
+            }
+        }
+    }
+    freeFormulaParser(parser);
+    free(counts);
+    return NULL;
+}
+
+/**
+ * @brief Runs the test on TEST_THREADS threads and prints the result.
+ *
+ * @param argc Argument count.
+ * @param argv Argument vector, with the periodic table file, if any.
+ * @return int 0 if every result was right, 1 otherwise.
+ */
+int main(int argc, char *argv[])
+{
+    PeriodicTable *table = argc > 1 ? getTable(argv[1]) : getDefaultTable();
+    if (table == NULL)
+    {
+        printf("Could not load the periodic table!\n");
+        return 1;
+    }
+
+    /* a buffer that is too small must tell the size it needs */
+    FormulaParser *parser = NULL;
+    char small[4];
+    size_t needed = 0;
+    int status = 1;
+    if (initFormulaParser(&parser, table) == FORMULA_OK &&
+        parseExpansion(parser, "Mg(OH)2", 7, small, sizeof(small), &needed) == FORMULA_NO_SPACE && needed == 7)
+    {
+        status = 0;
+    }
+    else
+    {
+        printf("parseExpansion did not report the size it needs!\n");
+    }
+    if (parser != NULL)
+    {
+        freeFormulaParser(parser);
+    }
+
+    TestThread threads[TEST_THREADS];
+    int started = 0;
+    for (; started < TEST_THREADS; started++)
+    {
+        threads[started].index = started;
+        threads[started].table = table;
+        threads[started].failures = 0;
+        if (pthread_create(&threads[started].thread, NULL, runTest, &threads[started]) != 0)
+        {
+            printf("Could not start a test thread!\n");
+            status = 1;
+            break;
+        }
+    }
+    long failures = 0;
+    for (int i = 0; i < started; i++)
+    {
+        pthread_join(threads[i].thread, NULL);
+        if (threads[i].failures < 0)
+        {
+            printf("Could not create the parser of thread %d!\n", i);
+            status = 1;
+        }
+        else
+        {
+            failures += threads[i].failures;
+        }
+    }
+    freeTable(table);
+
+    if (failures > 0)
+    {
+        status = 1;
+    }
+    printf("%d threads, %ld formulas, %ld wrong results\n", started, (long)started * TEST_ROUNDS * TEST_CASES, failures);
+    return status;
+}